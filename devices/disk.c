@@ -84,7 +84,7 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t sec_cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -207,44 +207,83 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
+	disk_read_multiple (d, sec_no, &buffer, 1, 1);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	disk_write_multiple (d, sec_no, &buffer, 1, 1);
+}
+
+/* Reads BUF_CNT * BUF_SECTORS sectors starting at SEC_NO from disk
+   D with a single command, BUF_SECTORS consecutive sectors into
+   each of BUFFERS[0] through BUFFERS[BUF_CNT - 1], which must have
+   room for that many sectors.  At most DISK_MULTIPLE_MAX sectors
+   may be read. */
+void
+disk_read_multiple (struct disk *d, disk_sector_t sec_no,
+		void *const buffers[], size_t buf_cnt, size_t buf_sectors) {
+	size_t sec_cnt = buf_cnt * buf_sectors;
 	struct channel *c;
+	size_t i;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (buffers != NULL);
+	ASSERT (sec_cnt > 0 && sec_cnt <= DISK_MULTIPLE_MAX);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
+	select_sector (d, sec_no, sec_cnt);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
+	for (i = 0; i < sec_cnt; i++) {
+		/* The disk interrupts as each sector becomes ready. */
+		sema_down (&c->completion_wait);
+		if (!wait_while_busy (d))
+			PANIC ("%s: disk read failed, sector=%"PRDSNu,
+					d->name, sec_no + (disk_sector_t) i);
+		input_sector (c, (uint8_t *) buffers[i / buf_sectors]
+				+ i % buf_sectors * DISK_SECTOR_SIZE);
+	}
+	d->read_cnt += sec_cnt;
 	lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
-   Internally synchronizes accesses to disks, so external
-   per-disk locking is unneeded. */
+/* Writes BUF_CNT * BUF_SECTORS sectors starting at SEC_NO to disk
+   D with a single command, BUF_SECTORS consecutive sectors from
+   each of BUFFERS[0] through BUFFERS[BUF_CNT - 1].  At most
+   DISK_MULTIPLE_MAX sectors may be written.  Returns after the
+   disk has acknowledged receiving all of the data. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+disk_write_multiple (struct disk *d, disk_sector_t sec_no,
+		const void *const buffers[], size_t buf_cnt, size_t buf_sectors) {
+	size_t sec_cnt = buf_cnt * buf_sectors;
 	struct channel *c;
+	size_t i;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (buffers != NULL);
+	ASSERT (sec_cnt > 0 && sec_cnt <= DISK_MULTIPLE_MAX);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
+	select_sector (d, sec_no, sec_cnt);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	for (i = 0; i < sec_cnt; i++) {
+		/* The disk asks for each sector in turn, and interrupts
+		   once it has taken it. */
+		if (!wait_while_busy (d))
+			PANIC ("%s: disk write failed, sector=%"PRDSNu,
+					d->name, sec_no + (disk_sector_t) i);
+		output_sector (c, (const uint8_t *) buffers[i / buf_sectors]
+				+ i % buf_sectors * DISK_SECTOR_SIZE);
+		sema_down (&c->completion_wait);
+	}
+	d->write_cnt += sec_cnt;
 	lock_release (&c->lock);
 }
 
@@ -400,17 +439,18 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and SEC_CNT to the disk's sector selection
+   registers.  (We use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t sec_cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (sec_no + sec_cnt <= d->capacity);
+	ASSERT (sec_no + sec_cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	/* A count of 0 means DISK_MULTIPLE_MAX. */
+	outb (reg_nsect (c), sec_cnt % DISK_MULTIPLE_MAX);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
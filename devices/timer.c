@@ -1,8 +1,10 @@
 #include "devices/timer.h"
 #include <debug.h>
+#include <heap.h>
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
@@ -17,9 +19,46 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency and the counter value for one tick. */
+#define PIT_HZ 1193180
+#define PIT_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest one-shot interval the 16-bit counter can express, in
+   whole ticks. */
+#define PIT_MAX_TICKS (0xffff / PIT_COUNT)
+
+#define NSEC_PER_SEC 1000000000LL
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* -tickless: Stop the periodic tick while idle? */
+bool timer_tickless;
+
+/* One-shot state, used by tickless idle and by hrtimers.  While
+   ONESHOT_ARMED is true the PIT is in one-shot mode and its
+   interrupt stands for ONESHOT_TICKS ticks, which is 0 for an
+   hrtimer interrupt in the middle of a tick.  ONESHOT_COUNT is the
+   count the PIT was loaded with and ONESHOT_FIRST is the number of
+   counts from arming to the next tick boundary, which may lie
+   beyond the one-shot. */
+static bool oneshot_armed;
+static int64_t oneshot_ticks;
+static unsigned oneshot_count;
+static unsigned oneshot_first;
+
+/* TSC clock.  TSC_HZ is 0 until timer_calibrate() has measured it;
+   until then timer_now_ns() counts in whole ticks.  TSC_MULT is
+   nanoseconds per cycle as a 32.32 fixed-point number, and the
+   clock reads TSC_BASE_NS when the TSC reads TSC_BASE. */
+static uint64_t tsc_hz;
+static uint64_t tsc_mult;
+static uint64_t tsc_base;
+static int64_t tsc_base_ns;
+
+/* Threads blocked in timer_hrsleep(), ordered by wakeup_ns. */
+static struct heap hrtimer_queue;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
@@ -28,20 +67,22 @@ static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void pit_periodic (void);
+static void pit_oneshot (unsigned count);
+static unsigned pit_read (bool *expired);
+static void pit_arm (int64_t ticks, unsigned count, unsigned first);
+static unsigned counts_to_boundary (void);
+static void hrtimer_expire (void);
+static void hrtimer_program (void);
+static heap_less_func hrtimer_less;
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void
 timer_init (void) {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
-
+	heap_init (&hrtimer_queue, hrtimer_less, NULL);
+	pit_periodic ();
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -68,6 +109,26 @@ timer_calibrate (void) {
 			loops_per_tick |= test_bit;
 
 	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+	/* Count TSC cycles across a tenth of a second of timer ticks,
+	   starting at a tick boundary. */
+	int64_t start = ticks;
+	uint64_t tsc_start;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	tsc_start = rdtsc ();
+	while (ticks - start < TIMER_FREQ / 10)
+		barrier ();
+
+	enum intr_level old_level = intr_disable ();
+	tsc_base = rdtsc ();
+	tsc_base_ns = ticks * (NSEC_PER_SEC / TIMER_FREQ);
+	tsc_mult = ((uint64_t) NSEC_PER_SEC << 32) / ((tsc_base - tsc_start) * 10);
+	tsc_hz = (tsc_base - tsc_start) * 10;
+	intr_set_level (old_level);
+
+	printf ("TSC: %'"PRIu64" Hz.\n", tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -87,6 +148,38 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then;
 }
 
+/* Returns the number of nanoseconds since the OS booted, read
+   from the TSC.  Monotonic; before timer_calibrate() it only
+   advances in whole ticks. */
+int64_t
+timer_now_ns (void) {
+	if (tsc_hz == 0)
+		return timer_ticks () * (NSEC_PER_SEC / TIMER_FREQ);
+	return tsc_base_ns
+		+ (int64_t) (((unsigned __int128) (rdtsc () - tsc_base) * tsc_mult) >> 32);
+}
+
+/* Blocks the current thread for at least NS nanoseconds, woken by
+   a one-shot timer interrupt programmed for its deadline rather
+   than by the next tick.  Intended for sleeps shorter than a
+   tick; timer_sleep() is cheaper for longer ones. */
+void
+timer_hrsleep (int64_t ns) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (intr_get_level () == INTR_ON);
+	if (ns <= 0)
+		return;
+
+	old_level = intr_disable ();
+	t->wakeup_ns = timer_now_ns () + ns;
+	heap_push (&hrtimer_queue, &t->sleep_elem);
+	hrtimer_program ();
+	thread_block ();
+	intr_set_level (old_level);
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void
 timer_sleep (int64_t ticks) {
@@ -121,9 +214,94 @@ timer_print_stats (void) {
 }
 
 
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  If tickless idle is enabled and the next sleeper is due
+   more than a tick from now, stops the periodic tick and instead
+   programs a single interrupt for that deadline (or as far ahead
+   as the counter reaches).  The phase of the periodic tick is
+   preserved, so no time is lost.
+
+   Not used with the 4.4BSD scheduler, which samples the run queue
+   on every tick. */
+void
+timer_tickless_enter (void) {
+	int64_t delta;
+	unsigned first;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (!timer_tickless || thread_mlfqs || oneshot_armed
+			|| !heap_empty (&hrtimer_queue))
+		return;
+
+	delta = get_next_tick_to_awake () - ticks;
+	if (delta <= 1)
+		return;
+	if (delta > PIT_MAX_TICKS)
+		delta = PIT_MAX_TICKS;
+
+	first = counts_to_boundary ();
+	pit_arm (delta, first + (delta - 1) * PIT_COUNT, first);
+}
+
+/* Called by the scheduler, with interrupts off, when it switches
+   away from the idle thread after tickless idle.  If the wakeup came from some
+   other interrupt before the one-shot expired, adds the ticks that
+   did elapse to the tick count, wakes any sleepers now due, and
+   programs one more short one-shot to the next tick boundary, at
+   which point the periodic tick resumes in phase. */
+void
+timer_tickless_exit (void) {
+	unsigned remaining, elapsed, crossed;
+	bool expired;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (!oneshot_armed || oneshot_ticks <= 1)
+		return;
+
+	/* An expired one-shot has an interrupt pending, which will do
+	   the accounting as soon as interrupts are enabled. */
+	remaining = pit_read (&expired);
+	if (expired || remaining > oneshot_count)
+		return;
+
+	elapsed = oneshot_count - remaining;
+	crossed = elapsed < oneshot_first
+		? 0 : 1 + (elapsed - oneshot_first) / PIT_COUNT;
+
+	ticks += crossed;
+	thread_account_idle (crossed);
+	remaining = counts_to_boundary ();
+	pit_arm (1, remaining, remaining);
+
+	if (ticks >= get_next_tick_to_awake ())
+		thread_awake (ticks);
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	if (oneshot_armed) {
+		int64_t skipped = oneshot_ticks - 1;
+
+		oneshot_armed = false;
+		if (oneshot_ticks == 0) {
+			/* An hrtimer deadline in the middle of a tick.  Run
+			   the rest of the tick as a one-shot. */
+			unsigned rest = oneshot_first - oneshot_count;
+
+			pit_arm (1, rest, rest);
+			hrtimer_expire ();
+			hrtimer_program ();
+			return;
+		}
+
+		/* End of a one-shot ending on a tick boundary: all but the
+		   last of its ticks were spent halted in the idle thread. */
+		pit_periodic ();
+		ticks += skipped;
+		thread_account_idle (skipped);
+	}
+
 	ticks++;
 	thread_tick ();
 	int64_t next_tick;
@@ -132,6 +310,138 @@ timer_interrupt (struct intr_frame *args UNUSED) {
 	{
 		thread_awake(ticks);
 	}
+	hrtimer_expire ();
+	hrtimer_program ();
+}
+
+/* Wakes every thread in timer_hrsleep() whose deadline has
+   passed. */
+static void
+hrtimer_expire (void) {
+	struct heap_elem *e;
+	int64_t now = timer_now_ns ();
+	bool woke = false;
+
+	while ((e = heap_top (&hrtimer_queue)) != NULL) {
+		struct thread *t = heap_entry (e, struct thread, sleep_elem);
+		if (t->wakeup_ns > now)
+			break;
+		heap_pop (&hrtimer_queue);
+		thread_unblock (t);
+		woke = true;
+	}
+	if (woke)
+		test_max_priority ();
+}
+
+/* If the earliest hrtimer deadline falls before the next tick
+   boundary, and before any one-shot already armed, programs a
+   one-shot interrupt for it.  Deadlines further away are picked
+   up again by the tick that precedes them. */
+static void
+hrtimer_program (void) {
+	struct heap_elem *e = heap_top (&hrtimer_queue);
+	unsigned to_boundary, count;
+	int64_t ns;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	if (e == NULL)
+		return;
+
+	to_boundary = counts_to_boundary ();
+	ns = heap_entry (e, struct thread, sleep_elem)->wakeup_ns - timer_now_ns ();
+	if (ns >= (int64_t) to_boundary * NSEC_PER_SEC / PIT_HZ)
+		return;
+
+	/* Round up, so that the interrupt never comes early. */
+	count = ns <= 0 ? 1 : (ns * PIT_HZ + NSEC_PER_SEC - 1) / NSEC_PER_SEC;
+	if (count >= to_boundary)
+		return;
+	if (oneshot_armed && oneshot_ticks == 0) {
+		bool expired;
+		unsigned remaining = pit_read (&expired);
+		if (expired || remaining <= count)
+			return;
+	}
+	pit_arm (0, count, to_boundary);
+}
+
+/* Orders threads in timer_hrsleep() by ascending deadline. */
+static bool
+hrtimer_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct thread, sleep_elem)->wakeup_ns
+		< heap_entry (b, struct thread, sleep_elem)->wakeup_ns;
+}
+
+/* Programs the 8254 PIT to interrupt TIMER_FREQ times per
+   second. */
+static void
+pit_periodic (void) {
+	/* 8254 input frequency divided by TIMER_FREQ, rounded to
+	   nearest. */
+	uint16_t count = PIT_COUNT;
+
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Programs the 8254 PIT to interrupt once, COUNT input clocks
+   from now. */
+static void
+pit_oneshot (unsigned count) {
+	ASSERT (count > 0 && count <= 0xffff);
+
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
+}
+
+/* Puts the PIT in one-shot mode for COUNT input clocks, standing
+   for TICK_CNT ticks, where the next tick boundary is FIRST counts
+   from now. */
+static void
+pit_arm (int64_t tick_cnt, unsigned count, unsigned first) {
+	oneshot_armed = true;
+	oneshot_ticks = tick_cnt;
+	oneshot_count = count;
+	oneshot_first = first;
+	pit_oneshot (count);
+}
+
+/* Returns the number of PIT input clocks from now to the next
+   tick boundary. */
+static unsigned
+counts_to_boundary (void) {
+	bool expired;
+	unsigned remaining = pit_read (&expired);
+	unsigned elapsed;
+
+	if (!oneshot_armed)
+		return remaining != 0 ? remaining : PIT_COUNT;
+
+	elapsed = expired || remaining > oneshot_count
+		? oneshot_count : oneshot_count - remaining;
+	if (elapsed < oneshot_first)
+		return oneshot_first - elapsed;
+	return PIT_COUNT - (elapsed - oneshot_first) % PIT_COUNT;
+}
+
+/* Returns the current value of PIT counter 0, and sets *EXPIRED
+   to its OUT pin, which in one-shot mode goes high once the count
+   has run out. */
+static unsigned
+pit_read (bool *expired) {
+	uint8_t status, lo, hi;
+
+	outb (0x43, 0xc2);    /* Read-back: latch status and count of counter 0. */
+	status = inb (0x40);
+	lo = inb (0x40);
+	hi = inb (0x40);
+
+	*expired = (status & 0x80) != 0;
+	return lo | (hi << 8);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -182,10 +492,15 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
 		timer_sleep (ticks);
+	} else if (tsc_hz != 0) {
+		/* Otherwise, block on a high-resolution timer for more
+		   accurate sub-tick timing. */
+		ASSERT (NSEC_PER_SEC % denom == 0);
+		timer_hrsleep (num * (NSEC_PER_SEC / denom));
 	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
+		/* Before the TSC is calibrated, use a busy-wait loop.  We
+		   scale the numerator and denominator down by 1000 to avoid
+		   the possibility of overflow. */
 		ASSERT (denom % 1000 == 0);
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
@@ -21,6 +21,7 @@ filesys_init (bool format) {
 	if (filesys_disk == NULL)
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
+	file_init ();
 	inode_init ();
 
 #ifdef EFILESYS
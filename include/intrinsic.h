@@ -1,4 +1,5 @@
 #ifndef INSTRINSIC_H
+#define INSTRINSIC_H
 #include "threads/mmu.h"
 
 /* Store the physical address of the page directory into CR3
@@ -128,4 +129,11 @@ static __inline void write_msr(uint32_t ecx, uint64_t val) {
 			:: "c" (ecx), "d" (edx), "a" (eax) );
 }
 
+__attribute__((always_inline))
+static __inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	__asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
 #endif /* intrinsic.h */
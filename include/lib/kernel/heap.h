@@ -0,0 +1,66 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Pairing heap.
+ *
+ * Like the list and hash table, this heap does not require use
+ * of dynamically allocated memory.  Each structure that is a
+ * potential heap element must embed a struct heap_elem member,
+ * and heap_entry() converts a struct heap_elem back to the
+ * structure object that contains it.
+ *
+ * The element for which LESS returns true against every other
+ * element is kept at the top, so a "less" function that compares
+ * wakeup times gives a min-heap of timers and one that compares
+ * priorities with `>' gives a max-heap of waiters.
+ *
+ * Costs: heap_push() and heap_top() are O(1), heap_pop() and
+ * heap_remove() are O(lg n) amortized.  An element whose key
+ * changes while it is in the heap must be taken out with
+ * heap_remove() and pushed back. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* Leftmost child. */
+	struct heap_elem *next;     /* Right sibling. */
+	struct heap_elem *prev;     /* Left sibling, or parent if leftmost. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child    \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A should be closer to the
+   top of the heap than B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Top element, or null if empty. */
+	size_t size;                /* Number of elements. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+
+size_t heap_size (struct heap *);
+bool heap_empty (struct heap *);
+
+#endif /* lib/kernel/heap.h */
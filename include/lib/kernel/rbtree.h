@@ -0,0 +1,67 @@
+#ifndef __LIB_KERNEL_RBTREE_H
+#define __LIB_KERNEL_RBTREE_H
+
+/* Red-black tree.
+ *
+ * Like the list, hash table and heap, this tree does not require
+ * use of dynamically allocated memory.  Each structure that is a
+ * potential tree element must embed a struct rb_node member, and
+ * rbtree_entry() converts a struct rb_node back to the structure
+ * object that contains it.
+ *
+ * Nodes are ordered by the tree's LESS function.  Nodes with equal
+ * keys are kept in insertion order, so the tree can serve as a
+ * run queue sorted by a key such as virtual runtime.  The leftmost
+ * node is cached, so rbtree_min() is O(1); rbtree_insert() and
+ * rbtree_remove() are O(lg n) worst case.  A node whose key
+ * changes while it is in the tree must be removed and inserted
+ * again. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Tree node. */
+struct rb_node {
+	struct rb_node *parent;     /* Parent, or null for the root. */
+	struct rb_node *left;       /* Left child. */
+	struct rb_node *right;      /* Right child. */
+	bool red;                   /* Red or black? */
+};
+
+/* Converts pointer to tree node RB_NODE into a pointer to the
+   structure that RB_NODE is embedded inside.  Supply the name of
+   the outer structure STRUCT and the member name MEMBER of the
+   tree node. */
+#define rbtree_entry(RB_NODE, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(RB_NODE)->parent     \
+		- offsetof (STRUCT, MEMBER.parent)))
+
+/* Compares the value of two tree nodes A and B, given auxiliary
+   data AUX.  Returns true if A is less than B, or false if A is
+   greater than or equal to B. */
+typedef bool rbtree_less_func (const struct rb_node *a,
+                               const struct rb_node *b,
+                               void *aux);
+
+/* Red-black tree. */
+struct rbtree {
+	struct rb_node *root;       /* Root, or null if empty. */
+	struct rb_node *min;        /* Leftmost node, or null if empty. */
+	size_t size;                /* Number of nodes. */
+	rbtree_less_func *less;     /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void rbtree_init (struct rbtree *, rbtree_less_func *, void *aux);
+
+void rbtree_insert (struct rbtree *, struct rb_node *);
+void rbtree_remove (struct rbtree *, struct rb_node *);
+
+struct rb_node *rbtree_min (struct rbtree *);
+struct rb_node *rbtree_next (struct rb_node *);
+
+size_t rbtree_size (struct rbtree *);
+bool rbtree_empty (struct rbtree *);
+
+#endif /* lib/kernel/rbtree.h */
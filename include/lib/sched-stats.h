@@ -0,0 +1,23 @@
+#ifndef __LIB_SCHED_STATS_H
+#define __LIB_SCHED_STATS_H
+
+#include <stdint.h>
+
+/* Scheduler statistics of one thread, kept by the kernel and
+   returned to user programs by the sched_stats() system call.
+
+   A thread's run-queue wait is the time from becoming READY, by
+   being unblocked or by yielding, to running again.  Wait
+   histogram bucket 0 counts waits under 1 us and bucket B > 0
+   counts waits in [2**(B-1), 2**B) us; the last bucket also
+   takes everything longer. */
+#define SCHED_WAIT_BUCKETS 24
+
+struct sched_stats {
+	int64_t wait_ns;            /* Total run-queue wait, in ns. */
+	uint64_t voluntary;         /* Switches out to block or exit. */
+	uint64_t involuntary;       /* Switches out while still READY. */
+	uint32_t wait_hist[SCHED_WAIT_BUCKETS]; /* Run-queue waits. */
+};
+
+#endif /* lib/sched-stats.h */
@@ -36,6 +36,9 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Diagnostics. */
+	SYS_SCHED_STATS,            /* Get scheduler statistics. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,82 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 signed fixed-point arithmetic for the 4.4BSD scheduler.
+ *
+ * A fixed-point value is stored in a plain int whose low
+ * FP_SHIFT bits are the fraction.  Products and quotients of two
+ * fixed-point values go through int64_t so that they do not
+ * overflow before being scaled back down. */
+
+#define FP_SHIFT 14                     /* Fraction bits. */
+#define FP_ONE (1 << FP_SHIFT)          /* 1.0 in fixed point. */
+
+/* Converts integer N to fixed point. */
+static inline int
+int_to_fp (int n) {
+	return n * FP_ONE;
+}
+
+/* Converts fixed-point X to an integer, rounding toward zero. */
+static inline int
+fp_to_int (int x) {
+	return x / FP_ONE;
+}
+
+/* Converts fixed-point X to an integer, rounding to nearest. */
+static inline int
+fp_to_int_round (int x) {
+	return x >= 0 ? (x + FP_ONE / 2) / FP_ONE : (x - FP_ONE / 2) / FP_ONE;
+}
+
+/* Returns X + Y, both fixed point. */
+static inline int
+fp_add (int x, int y) {
+	return x + y;
+}
+
+/* Returns X - Y, both fixed point. */
+static inline int
+fp_sub (int x, int y) {
+	return x - y;
+}
+
+/* Returns fixed-point X plus integer N. */
+static inline int
+fp_add_int (int x, int n) {
+	return x + n * FP_ONE;
+}
+
+/* Returns fixed-point X minus integer N. */
+static inline int
+fp_sub_int (int x, int n) {
+	return x - n * FP_ONE;
+}
+
+/* Returns X * Y, both fixed point. */
+static inline int
+fp_mul (int x, int y) {
+	return ((int64_t) x) * y / FP_ONE;
+}
+
+/* Returns fixed-point X times integer N. */
+static inline int
+fp_mul_int (int x, int n) {
+	return x * n;
+}
+
+/* Returns X / Y, both fixed point. */
+static inline int
+fp_div (int x, int y) {
+	return ((int64_t) x) * FP_ONE / y;
+}
+
+/* Returns fixed-point X divided by integer N. */
+static inline int
+fp_div_int (int x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed-point.h */
@@ -0,0 +1,29 @@
+#ifndef THREADS_LOCKSTAT_H
+#define THREADS_LOCKSTAT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Lock contention statistics, collected when the kernel is built
+   with LOCKSTAT.  Locks are counted per name, as given to
+   lock_set_name(), and all times are in TSC cycles. */
+struct lockstat {
+	const char *name;           /* Lock name. */
+	uint64_t acquired;          /* # of acquisitions. */
+	uint64_t contended;         /* # of acquisitions that had to wait. */
+	uint64_t wait_cycles;       /* Total time spent waiting. */
+	uint64_t max_wait;          /* Longest wait. */
+	uint64_t hold_cycles;       /* Total time held. */
+	uint64_t max_hold;          /* Longest hold. */
+};
+
+/* Number of locks lockstat_print_stats() prints; set by the
+   -lockstat=N kernel option. */
+extern int lockstat_top;
+
+struct lockstat *lockstat_lookup (const char *name);
+void lockstat_acquired (struct lockstat *, bool contended, uint64_t wait);
+void lockstat_released (struct lockstat *, uint64_t hold);
+void lockstat_print_stats (void);
+
+#endif /* threads/lockstat.h */
@@ -19,5 +19,9 @@ void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+size_t palloc_free_cnt (enum palloc_flags);
+int palloc_largest_order (enum palloc_flags);
+size_t palloc_pool_range (enum palloc_flags, void **base);
+void palloc_print_stats (void);
 
 #endif /* threads/palloc.h */
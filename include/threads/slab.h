@@ -0,0 +1,27 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches.
+ *
+ * A cache hands out objects of a single size, packed into
+ * page-sized slabs with only a small header, so that objects
+ * whose size falls just above a power of two do not waste half a
+ * malloc() block each.  An optional constructor runs once on
+ * every object when its slab is created; objects should be
+ * returned to the cache in their constructed state, except that
+ * the cache keeps its free list in the first pointer-sized word
+ * of each free object. */
+
+struct kmem_cache;
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+                                      void (*ctor) (void *));
+void *kmem_cache_alloc (struct kmem_cache *) __attribute__ ((malloc));
+void *kmem_cache_zalloc (struct kmem_cache *) __attribute__ ((malloc));
+void kmem_cache_free (struct kmem_cache *, void *);
+size_t kmem_cache_objs_per_slab (const struct kmem_cache *);
+void kmem_cache_print_stats (void);
+
+#endif /* threads/slab.h */
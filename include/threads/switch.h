@@ -0,0 +1,31 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+
+struct thread;
+
+/* switch_threads()'s stack frame: the callee-saved registers,
+   pushed in reverse order, and the return address. */
+struct switch_threads_frame {
+	uint64_t r15;               /*  0: Saved %r15. */
+	uint64_t r14;               /*  8: Saved %r14. */
+	uint64_t r13;               /* 16: Saved %r13. */
+	uint64_t r12;               /* 24: Saved %r12. */
+	uint64_t rbp;               /* 32: Saved %rbp. */
+	uint64_t rbx;               /* 40: Saved %rbx. */
+	void (*rip) (void);         /* 48: Return address. */
+};
+
+/* Switches from CUR, which must be the running thread, to NEXT,
+   which must also be running switch_threads(), returning CUR in
+   NEXT's context. */
+struct thread *switch_threads (struct thread *cur, struct thread *next);
+
+/* Where a new thread's first switch_threads() returns to.  Calls
+   the function in %r14, passing %r12 and %r13 as its arguments. */
+void switch_entry (void);
+#endif
+
+#endif /* threads/switch.h */
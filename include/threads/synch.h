@@ -1,13 +1,15 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, highest priority on top. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -20,32 +22,54 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+#ifdef LOCKSTAT
+	struct lockstat *stat;      /* Statistics, or null if unnamed. */
+	uint64_t acquired_at;       /* TSC when the holder got it. */
+#endif
 };
 
 void lock_init (struct lock *);
+void lock_set_name (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Reader-writer lock.  Any number of readers or a single writer
+   may hold it.  Writer-preferring: once a writer is waiting, new
+   readers wait behind it, so a reader must not try to take the
+   lock again while it already holds it.  Each thread remembers
+   the locks it holds for reading, up to RWLOCK_READ_MAX of them
+   at once, so that a thread that exits while reading can let go. */
+#define RWLOCK_READ_MAX 4
+
+struct rwlock {
+	struct lock writer;         /* Held by the writer, waiting or not. */
+	struct semaphore drained;   /* Upped when the last reader leaves. */
+	unsigned readers;           /* # of readers holding the lock. */
+	bool draining;              /* Writer waiting for readers to leave? */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_set_name (struct rwlock *, const char *name);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+bool rwlock_read_by_current_thread (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiters, highest priority on top. */
 };
 
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
-/*-------------------------- project.1-Priority Sync -----------------------------*/
-bool cmp_sem_priority (const struct list_elem *, const struct list_elem *, void *);
-/*-------------------------- project.1-Priority Sync -----------------------------*/
-
-
-/*-------------------------- project.1-Priority Sync -----------------------------*/
-bool cmp_sem_priority (const struct list_elem *, const struct list_elem *, void *);
 
-/*-------------------------- project.1-Priority Sync -----------------------------*/
+void synch_change_priority (struct thread *, int priority);
 
 /* Optimization barrier.
  *
@@ -2,7 +2,10 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
+#include <rbtree.h>
+#include <sched-stats.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h"
@@ -19,6 +22,18 @@ enum thread_status {
 	THREAD_DYING        /* About to be destroyed. */
 };
 
+/* Scheduling policies.  Threads under SCHED_FIFO or SCHED_RR are
+   real-time: any READY real-time thread runs ahead of every
+   SCHED_OTHER thread, whichever scheduler those use, and
+   real-time threads are ordered among themselves by priority.
+   A SCHED_FIFO thread runs until it blocks or yields; a SCHED_RR
+   thread is also preempted when its time slice runs out. */
+enum sched_policy {
+	SCHED_OTHER,        /* Normal time sharing. */
+	SCHED_FIFO,         /* Real-time, no time slice. */
+	SCHED_RR            /* Real-time, round robin. */
+};
+
 /* Thread identifier type.
    You can redefine this to whatever type you like. */
 typedef int tid_t;
@@ -38,6 +53,7 @@ typedef int tid_t;
  * the page (at offset 4 kB).  Here's an illustration:
  *
  *      4 kB +---------------------------------+
+ *           |      switch_threads_frame       |
  *           |          kernel stack           |
  *           |                |                |
  *           |                |                |
@@ -53,13 +69,19 @@ typedef int tid_t;
  *           |                                 |
  *           +---------------------------------+
  *           |              magic              |
- *           |            intr_frame           |
+ *           |              stack              |
  *           |                :                |
  *           |                :                |
  *           |               name              |
  *           |              status             |
  *      0 kB +---------------------------------+
  *
+ * A thread that is not running keeps its registers on its own
+ * kernel stack, in the struct switch_threads_frame that
+ * switch_threads() pushed, and `stack' holds the stack pointer
+ * that points at it.  thread_create() builds the first such
+ * frame at the very top of the page.
+ *
  * The upshot of this is twofold:
  *
  *    1. First, `struct thread' must not be allowed to grow too
@@ -92,12 +114,45 @@ struct thread {
 	enum thread_status status;          /* Thread state. */
 	char name[16];                      /* Name (for debugging purposes). */
 	int priority;                       /* Priority. */
+	int page_refs;                      /* References to this page. */
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
 
 	// 깨어나야할 tick 저장 (wakeup_tick)
 	int64_t wakeup_tick;
+	int64_t wakeup_ns;                  /* Deadline in timer_hrsleep(). */
+	struct heap_elem sleep_elem;        /* Sleep or hrtimer queue element. */
+
+	/* 4.4BSD scheduler state (see thread_mlfqs). */
+	int nice;                           /* Niceness. */
+	int recent_cpu;                     /* Fixed point, as of load_epoch. */
+	int64_t load_epoch;                 /* Second recent_cpu was decayed to. */
+
+	/* Real-time scheduling (see thread_set_policy()). */
+	enum sched_policy policy;           /* Scheduling policy. */
+
+	/* Scheduler accounting. */
+	int64_t ready_ns;                   /* When it last became READY. */
+	bool woken;                         /* Made READY by thread_unblock()? */
+	struct sched_stats sched_stats;     /* Waits and context switches. */
+	struct list_elem allelem;           /* List element for all threads list. */
+
+	/* Fair-share scheduler state (see thread_cfs). */
+	struct rb_node cfs_node;            /* Run queue tree node. */
+	int64_t vruntime;                   /* Weighted run time, in ns. */
+
+	/* Owned by malloc.c. */
+	struct magazine *magazines;         /* Free blocks by size class. */
+
+	/* Owned by synch.c. */
+	struct semaphore *wait_sema;        /* Semaphore blocked on, if any. */
+	struct condition *wait_cond;        /* Condition waited on, if any. */
+	struct heap_elem wait_elem;         /* wait_sema's waiters element. */
+	struct heap_elem *cond_elem;        /* Its waiter in wait_cond. */
+	uint64_t wait_seq;                  /* Arrival order among waiters. */
+	struct rwlock *read_locks[RWLOCK_READ_MAX]; /* Held for reading. */
+	int read_lock_cnt;                  /* Entries in read_locks. */
 
 	int init_priority;
 	struct lock *wait_on_lock;
@@ -134,7 +189,7 @@ struct thread {
 #endif
 
 	/* Owned by thread.c. */
-	struct intr_frame tf;               /* Information for switching */
+	uint8_t *stack;                     /* Saved stack pointer. */
 	unsigned magic;                     /* Detects stack overflow. */
 
 
@@ -145,11 +200,23 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the weighted fair-share scheduler instead, which
+   divides the CPU among ready threads in proportion to weights
+   derived from their priority and nice value.
+   Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
+/* If true (default), thread_create() reuses the pages of dead
+   threads.  Turned off only to measure what the cache saves. */
+extern bool thread_cache_enabled;
+
 void thread_init (void);
 void thread_start (void);
 
 void thread_tick (void);
+void thread_account_idle (int64_t cnt);
 void thread_print_stats (void);
+void thread_get_sched_stats (struct sched_stats *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -162,11 +229,15 @@ tid_t thread_tid (void);
 const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
+void thread_page_put (struct thread *);
 void thread_yield (void);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
 
+enum sched_policy thread_get_policy (void);
+void thread_set_policy (enum sched_policy);
+
 int thread_get_nice (void);
 void thread_set_nice (int);
 int thread_get_recent_cpu (void);
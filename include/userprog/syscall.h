@@ -9,7 +9,7 @@
 // #include <stddef.h>
 /*-------------------------- project.2-System Call -----------------------------*/
 
-// static struct lock filesys_lock;
+// static struct rwlock filesys_lock;
 void syscall_init (void);
 
 
@@ -26,6 +26,6 @@ int filesize(int);
 int read (int , void*, unsigned);
 int write(int, const void *, unsigned );
 
-struct lock filesys_lock;
+struct rwlock filesys_lock;
 /*-------------------------- project.2-System call -----------------------------*/
 #endif /* userprog/syscall.h */
@@ -5,12 +5,11 @@ struct page;
 enum vm_type;
 
 struct anon_page {
-    size_t st_number;
+    size_t st_number;       /* Swap slot, or SWAP_NONE if resident. */
 };
 
-#define SECTOR_PER_PAGE 8
-
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+size_t anon_swap_out_batch (struct page *pages[], size_t cnt);
 
 #endif
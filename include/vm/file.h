@@ -23,6 +23,9 @@ struct file_aux {
 	bool writable;				/* True일 경우 해당 주소에 write 가능, False일 경우 */
 };
 
+/* Object cache for struct file_aux. */
+extern struct kmem_cache *file_aux_cache;
+
 void vm_file_init (void);
 bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
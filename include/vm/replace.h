@@ -0,0 +1,31 @@
+#ifndef VM_REPLACE_H
+#define VM_REPLACE_H
+#include <stdbool.h>
+#include "vm/vm.h"
+
+/* A page replacement policy: how the frame table picks the frame
+ * to evict when the user pool is empty.
+ * Policies look only at frames holding one page, or several
+ * anonymous pages shared copy-on-write.  They test the accessed
+ * bits in the page tables of the processes that own those pages,
+ * and the dirty bit of FRAME->PAGE in FRAME->THREAD's.
+ * SELECT_VICTIM runs with the frame table locked; NOTE_INSERT and
+ * NOTE_ACCESS may be null. */
+struct replace_policy {
+	const char *name;
+	/* FRAME has just been given a page. */
+	void (*note_insert) (struct frame *frame);
+	/* The page in FRAME was referenced through a page fault. */
+	void (*note_access) (struct frame *frame);
+	/* Returns the frame to evict, or NULL if none can be. */
+	struct frame *(*select_victim) (void);
+};
+
+/* Policy in use.  Controlled by kernel command-line option
+ * "-vm-replace=POLICY"; wsclock by default. */
+extern const struct replace_policy *replace_policy;
+
+bool replace_policy_set (const char *name);
+void replace_print_stats (void);
+
+#endif  /* VM_REPLACE_H */
@@ -0,0 +1,25 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+#include <stddef.h>
+#include <stdint.h>
+
+/* Swap slots: page-sized pieces of the swap disk.
+ * Slots are handed out in runs of adjacent slots so that several
+ * pages can be written with one disk command, and are reference
+ * counted so that pages shared after fork can share a slot. */
+
+/* Slot number that means "no slot". */
+#define SWAP_NONE SIZE_MAX
+
+/* Most slots one swap_alloc() or swap_write() can cover. */
+#define SWAP_BATCH_MAX 16
+
+void swap_init (void);
+size_t swap_alloc (size_t cnt);
+void swap_dup (size_t slot);
+void swap_free (size_t slot);
+void swap_read (size_t slot, void *kva);
+void swap_write (size_t slot, void *const kvas[], size_t cnt);
+void swap_print_stats (void);
+
+#endif  /* VM_SWAP_H */
@@ -2,6 +2,8 @@
 #define VM_VM_H
 #include <stdbool.h>
 #include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/slab.h"
 
 
 
@@ -57,9 +59,11 @@ struct page {
 	const struct page_operations *operations;
 	void *va;              /* Address in terms of user space */
 	struct frame *frame;   /* Back reference for frame */
+	struct thread *owner;  /* Process whose spt holds this page. */
 
 	/* Your implementation */
 	int mapping_id;
+	struct list_elem frame_elem;	/* Element in frame->pages. */
 	bool writable;				/* True일 경우 해당 주소에 write 가능, False일 경우 해당 주소에 write 불가능 */
 	bool is_loaded;				/* 물리메모리의 탑재 여부를 알려주는 플래그 */
 	size_t swap_slot;			/* 스왑 슬롯 */
@@ -118,12 +122,24 @@ struct load_aux {
 // 	struct list_elem elem; // thread의 mmap_list에서 쓰는 리스트 elem
 // }
 
-/* The representation of "frame" */
+/* The representation of "frame".
+ * There is one frame for each page of the user pool, in an array
+ * indexed by its kva, so KVA never changes and a frame is free
+ * while REF_CNT is 0.
+ * After fork, several pages may share a frame copy-on-write: each
+ * is on PAGES and mapped read-only until it is written, and PAGE
+ * is one of them. */
 struct frame {
 	void *kva;
 	struct page *page;
-	struct thread *thread;
-	struct list_elem list_elem;
+	struct thread *thread;      /* Owner of PAGE. */
+	struct list pages;          /* Pages using this frame. */
+	int ref_cnt;                /* Number of pages on PAGES, or 0
+	                               while the reclaimer writes them. */
+
+	/* Page replacement state (see vm/replace.c). */
+	uint8_t age;                /* Aging: reference history. */
+	int64_t last_use;           /* WSClock: tick of last use. */
 };
 
 /* The function table for page operations.
@@ -149,14 +165,10 @@ struct supplemental_page_table {
 	/* ---------------------- >> Project.3 MEM Management >> ---------------------------- */
     struct hash vm;
 	/* ---------------------- << Project.3 MEM Management << ---------------------------- */
+	struct rwlock lock;         /* Shared by lookups, exclusive for inserts/removals. */
 
 };
 
-struct lock spt_lock;
-struct list clock_list;
-struct lock clock_list_lock;
-struct list_elem *clock_ptr;
-
 #include "threads/thread.h"
 void supplemental_page_table_init (struct supplemental_page_table *spt);
 bool supplemental_page_table_copy (struct supplemental_page_table *dst,
@@ -167,7 +179,12 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
+/* Object caches for pages and lazy-load arguments. */
+extern struct kmem_cache *page_cache;
+extern struct kmem_cache *load_aux_cache;
+
 void vm_init (void);
+void vm_print_stats (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
 
@@ -185,11 +202,17 @@ bool page_less (const struct hash_elem *a_,
            const struct hash_elem *b_, void *aux UNUSED);
 void page_delete(const struct hash_elem *e, void *aux);
 
-void add_frame_to_clock_list(struct frame *frame);
-void del_frame_to_clock_list(struct frame *frame);
+extern struct frame *frame_table;
+extern size_t frame_cnt;
+
+/* Free-frame watermarks for the reclaimer thread.  It wakes when
+ * fewer than RECLAIM_LOW frames are free and evicts until there
+ * are RECLAIM_HIGH. */
+extern size_t reclaim_low;
+extern size_t reclaim_high;
+
 struct frame *alloc_frame(void);
 void free_frame(void *kva);
-void __free_page(struct frame *frame);
-struct list_elem *get_next_clock();
+struct frame *frame_lookup (void *kva);
 
 #endif  /* VM_VM_H */
@@ -23,12 +23,23 @@ typedef unsigned long elem_type;
 
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   Bitmaps of more than SUMMARY_MIN_ELEMS elements also keep a
+   summary, one bit per element that is set iff the element has
+   at least one bit set to false, so that searching for free bits
+   skips whole runs of full elements ELEM_BITS at a time.  Bits
+   in the last element beyond BIT_CNT are always false. */
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	elem_type *summary; /* Elements with a false bit, or null. */
+	size_t hint;        /* Where the next next-fit scan starts. */
 };
 
+/* Minimum number of elements for a bitmap to keep a summary. */
+#define SUMMARY_MIN_ELEMS ELEM_BITS
+
 /* Returns the index of the element that contains the bit
    numbered BIT_IDX. */
 static inline size_t
@@ -55,6 +66,14 @@ byte_cnt (size_t bit_cnt) {
 	return sizeof (elem_type) * elem_cnt (bit_cnt);
 }
 
+/* Returns the number of bytes of summary kept for a bitmap of
+   BIT_CNT bits, which is 0 if it keeps none. */
+static inline size_t
+summary_byte_cnt (size_t bit_cnt) {
+	size_t cnt = elem_cnt (bit_cnt);
+	return cnt > SUMMARY_MIN_ELEMS ? byte_cnt (cnt) : 0;
+}
+
 /* Returns a bit mask in which the bits actually used in the last
    element of B's bits are set to 1 and the rest are set to 0. */
 static inline elem_type
@@ -62,7 +81,66 @@ last_mask (const struct bitmap *b) {
 	int last_bits = b->bit_cnt % ELEM_BITS;
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
-
+
+/* Returns a bit mask of the bits of element IDX of B that are
+   in use. */
+static inline elem_type
+elem_mask (const struct bitmap *b, size_t idx) {
+	return idx == elem_cnt (b->bit_cnt) - 1 ? last_mask (b) : (elem_type) -1;
+}
+
+/* Returns a mask of the CNT bits of an element starting at bit
+   OFS.  OFS + CNT must not exceed ELEM_BITS. */
+static inline elem_type
+range_mask (size_t ofs, size_t cnt) {
+	elem_type mask = cnt < ELEM_BITS ? ((elem_type) 1 << cnt) - 1 : (elem_type) -1;
+	return mask << ofs;
+}
+
+/* Atomically sets the bits of MASK in *E, which is equivalent to
+   `*e |= mask' except that it is guaranteed to be atomic on a
+   uniprocessor machine.  See the description of the OR
+   instruction in [IA32-v2b]. */
+static inline void
+elem_or (elem_type *e, elem_type mask) {
+	asm ("lock orq %1, %0" : "+m" (*e) : "r" (mask) : "cc");
+}
+
+/* Atomically clears the bits of MASK in *E, which is equivalent
+   to `*e &= ~mask' except that it is guaranteed to be atomic on
+   a uniprocessor machine.  See the description of the AND
+   instruction in [IA32-v2a]. */
+static inline void
+elem_clear (elem_type *e, elem_type mask) {
+	asm ("lock andq %1, %0" : "+m" (*e) : "r" (~mask) : "cc");
+}
+
+/* Brings B's summary bit for element IDX up to date. */
+static inline void
+summary_update (struct bitmap *b, size_t idx) {
+	if (b->summary != NULL) {
+		elem_type mask = elem_mask (b, idx);
+
+		if ((b->bits[idx] & mask) == mask)
+			elem_clear (&b->summary[elem_idx (idx)], bit_mask (idx));
+		else
+			elem_or (&b->summary[elem_idx (idx)], bit_mask (idx));
+	}
+}
+
+/* Recomputes all of B's summary from its bits. */
+static void
+summary_rebuild (struct bitmap *b) {
+	size_t i;
+
+	if (b->summary == NULL)
+		return;
+	for (i = 0; i < elem_cnt (elem_cnt (b->bit_cnt)); i++)
+		b->summary[i] = 0;
+	for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+		summary_update (b, i);
+}
+
 /* Creation and destruction. */
 
 /* Initializes B to be a bitmap of BIT_CNT bits
@@ -75,10 +153,17 @@ bitmap_create (size_t bit_cnt) {
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
 		b->bits = malloc (byte_cnt (bit_cnt));
-		if (b->bits != NULL || bit_cnt == 0) {
+		b->summary = NULL;
+		b->hint = 0;
+		if (summary_byte_cnt (bit_cnt) > 0)
+			b->summary = malloc (summary_byte_cnt (bit_cnt));
+		if ((b->bits != NULL || bit_cnt == 0)
+				&& (b->summary != NULL || summary_byte_cnt (bit_cnt) == 0)) {
 			bitmap_set_all (b, false);
 			return b;
 		}
+		free (b->summary);
+		free (b->bits);
 		free (b);
 	}
 	return NULL;
@@ -95,6 +180,10 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 
 	b->bit_cnt = bit_cnt;
 	b->bits = (elem_type *) (b + 1);
+	b->summary = NULL;
+	b->hint = 0;
+	if (summary_byte_cnt (bit_cnt) > 0)
+		b->summary = b->bits + elem_cnt (bit_cnt);
 	bitmap_set_all (b, false);
 	return b;
 }
@@ -103,7 +192,8 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
    with BIT_CNT bits (for use with bitmap_create_in_buf()). */
 size_t
 bitmap_buf_size (size_t bit_cnt) {
-	return sizeof (struct bitmap) + byte_cnt (bit_cnt);
+	return sizeof (struct bitmap) + byte_cnt (bit_cnt)
+		+ summary_byte_cnt (bit_cnt);
 }
 
 /* Destroys bitmap B, freeing its storage.
@@ -112,11 +202,12 @@ bitmap_buf_size (size_t bit_cnt) {
 void
 bitmap_destroy (struct bitmap *b) {
 	if (b != NULL) {
+		free (b->summary);
 		free (b->bits);
 		free (b);
 	}
 }
-
+
 /* Bitmap size. */
 
 /* Returns the number of bits in B. */
@@ -124,7 +215,7 @@ size_t
 bitmap_size (const struct bitmap *b) {
 	return b->bit_cnt;
 }
-
+
 /* Setting and testing single bits. */
 
 /* Atomically sets the bit numbered IDX in B to VALUE. */
@@ -142,24 +233,18 @@ bitmap_set (struct bitmap *b, size_t idx, bool value) {
 void
 bitmap_mark (struct bitmap *b, size_t bit_idx) {
 	size_t idx = elem_idx (bit_idx);
-	elem_type mask = bit_mask (bit_idx);
 
-	/* This is equivalent to `b->bits[idx] |= mask' except that it
-	   is guaranteed to be atomic on a uniprocessor machine.  See
-	   the description of the OR instruction in [IA32-v2b]. */
-	asm ("lock orq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	elem_or (&b->bits[idx], bit_mask (bit_idx));
+	summary_update (b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
 void
 bitmap_reset (struct bitmap *b, size_t bit_idx) {
 	size_t idx = elem_idx (bit_idx);
-	elem_type mask = bit_mask (bit_idx);
 
-	/* This is equivalent to `b->bits[idx] &= ~mask' except that it
-	   is guaranteed to be atomic on a uniprocessor machine.  See
-	   the description of the AND instruction in [IA32-v2a]. */
-	asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	elem_clear (&b->bits[idx], bit_mask (bit_idx));
+	summary_update (b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -173,7 +258,8 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) {
 	/* This is equivalent to `b->bits[idx] ^= mask' except that it
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the XOR instruction in [IA32-v2b]. */
-	asm ("lock xorq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	asm ("lock xorq %1, %0" : "+m" (b->bits[idx]) : "r" (mask) : "cc");
+	summary_update (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -183,44 +269,64 @@ bitmap_test (const struct bitmap *b, size_t idx) {
 	ASSERT (idx < b->bit_cnt);
 	return (b->bits[elem_idx (idx)] & bit_mask (idx)) != 0;
 }
-
+
 /* Setting and testing multiple bits. */
 
 /* Sets all bits in B to VALUE. */
 void
 bitmap_set_all (struct bitmap *b, bool value) {
+	size_t i;
+
 	ASSERT (b != NULL);
 
-	bitmap_set_multiple (b, 0, bitmap_size (b), value);
+	for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+		b->bits[i] = value ? elem_mask (b, i) : 0;
+	summary_rebuild (b);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE, a whole
+   element at a time. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	while (cnt > 0) {
+		size_t idx = elem_idx (start);
+		size_t ofs = start % ELEM_BITS;
+		size_t n = ELEM_BITS - ofs < cnt ? ELEM_BITS - ofs : cnt;
+
+		if (value)
+			elem_or (&b->bits[idx], range_mask (ofs, n));
+		else
+			elem_clear (&b->bits[idx], range_mask (ofs, n));
+		summary_update (b, idx);
+		start += n;
+		cnt -= n;
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
    exclusive, that are set to VALUE. */
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i, value_cnt;
+	size_t value_cnt;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
 	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			value_cnt++;
+	while (cnt > 0) {
+		size_t ofs = start % ELEM_BITS;
+		size_t n = ELEM_BITS - ofs < cnt ? ELEM_BITS - ofs : cnt;
+		elem_type e = b->bits[elem_idx (start)];
+
+		value_cnt += __builtin_popcountl ((value ? e : ~e) & range_mask (ofs, n));
+		start += n;
+		cnt -= n;
+	}
 	return value_cnt;
 }
 
@@ -228,15 +334,20 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
+	while (cnt > 0) {
+		size_t ofs = start % ELEM_BITS;
+		size_t n = ELEM_BITS - ofs < cnt ? ELEM_BITS - ofs : cnt;
+		elem_type e = b->bits[elem_idx (start)];
+
+		if (((value ? e : ~e) & range_mask (ofs, n)) != 0)
 			return true;
+		start += n;
+		cnt -= n;
+	}
 	return false;
 }
 
@@ -260,24 +371,90 @@ bool
 bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 	return !bitmap_contains (b, start, cnt, false);
 }
-
+
 /* Finding set or unset bits. */
 
+/* Returns the index of the first element at or after IDX whose
+   summary bit is set, that is, that has a false bit, or the
+   number of elements in B if there is none.  B must have a
+   summary. */
+static size_t
+summary_next (const struct bitmap *b, size_t idx) {
+	size_t cnt = elem_cnt (b->bit_cnt);
+	size_t s = elem_idx (idx);
+	elem_type e;
+
+	if (idx >= cnt)
+		return cnt;
+	e = b->summary[s] & ((elem_type) -1 << (idx % ELEM_BITS));
+	while (e == 0) {
+		if (++s >= elem_cnt (cnt))
+			return cnt;
+		e = b->summary[s];
+	}
+	return s * ELEM_BITS + __builtin_ctzl (e);
+}
+
+/* Returns the index of the first bit in B at or after START and
+   before LIMIT that is set to VALUE, or LIMIT if there is none.
+   LIMIT must not exceed B's size.  Looks at a whole element at a
+   time and, when looking for a false bit, skips full elements
+   through the summary. */
+static size_t
+find_next (const struct bitmap *b, size_t start, size_t limit, bool value) {
+	size_t idx, last, bit;
+	elem_type e;
+
+	if (start >= limit)
+		return limit;
+	idx = elem_idx (start);
+	last = elem_idx (limit - 1);
+	e = value ? b->bits[idx] : ~b->bits[idx];
+	e &= (elem_type) -1 << (start % ELEM_BITS);
+	while (e == 0) {
+		if (++idx > last)
+			return limit;
+		if (!value && b->summary != NULL) {
+			idx = summary_next (b, idx);
+			if (idx > last)
+				return limit;
+		}
+		e = value ? b->bits[idx] : ~b->bits[idx];
+	}
+	bit = idx * ELEM_BITS + __builtin_ctzl (e);
+	return bit < limit ? bit : limit;
+}
+
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+
+   Each step finds the next bit set to VALUE and then the end of
+   the run it starts, both a whole element at a time; a run that
+   is too short is skipped entirely. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
+	if (cnt == 0)
+		return start;
 	if (cnt <= b->bit_cnt) {
 		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
+		size_t i = start;
+
+		while (i <= last) {
+			size_t end;
+
+			i = find_next (b, i, last + 1, value);
+			if (i > last)
+				break;
+			end = find_next (b, i, i + cnt, !value);
+			if (end == i + cnt)
 				return i;
+			i = end;
+		}
 	}
 	return BITMAP_ERROR;
 }
@@ -296,7 +473,25 @@ bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value) {
 		bitmap_set_multiple (b, idx, cnt, !value);
 	return idx;
 }
-
+
+/* Like bitmap_scan_and_flip(), but next fit: starts where the
+   previous call left off and wraps around to the beginning of B,
+   so that successive allocations do not rescan the same full
+   prefix. */
+size_t
+bitmap_scan_and_flip_next (struct bitmap *b, size_t cnt, bool value) {
+	size_t start = b->hint <= b->bit_cnt ? b->hint : 0;
+	size_t idx = bitmap_scan (b, start, cnt, value);
+
+	if (idx == BITMAP_ERROR && start > 0)
+		idx = bitmap_scan (b, 0, cnt, value);
+	if (idx != BITMAP_ERROR) {
+		bitmap_set_multiple (b, idx, cnt, !value);
+		b->hint = idx + cnt;
+	}
+	return idx;
+}
+
 /* File input and output. */
 
 #ifdef FILESYS
@@ -315,6 +510,7 @@ bitmap_read (struct bitmap *b, struct file *file) {
 		off_t size = byte_cnt (b->bit_cnt);
 		success = file_read_at (file, b->bits, size, 0) == size;
 		b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+		summary_rebuild (b);
 	}
 	return success;
 }
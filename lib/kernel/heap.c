@@ -0,0 +1,168 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* A pairing heap is a heap-ordered multiway tree.  Each node
+   keeps a pointer to its leftmost child and doubly links to its
+   siblings; the leftmost child's `prev' points to the parent
+   instead, which lets heap_remove() unlink an arbitrary node in
+   constant time.
+
+   Two trees are joined ("melded") by making the root that loses
+   the comparison the leftmost child of the other.  Popping the
+   top merges its children back into one tree in two passes:
+   first pairwise from left to right, then from right to left.
+   Both passes are iterative so that deep heaps do not eat into
+   the small kernel stacks. */
+
+static struct heap_elem *meld (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+
+/* Initializes heap H as an empty heap ordered by LESS given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->size = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts ELEM into heap H. */
+void
+heap_push (struct heap *h, struct heap_elem *elem) {
+	ASSERT (h != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->next = elem->prev = NULL;
+	h->root = meld (h, h->root, elem);
+	h->size++;
+}
+
+/* Returns the top element of H, or a null pointer if H is
+   empty. */
+struct heap_elem *
+heap_top (struct heap *h) {
+	ASSERT (h != NULL);
+	return h->root;
+}
+
+/* Removes and returns the top element of H, or returns a null
+   pointer if H is empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top;
+
+	ASSERT (h != NULL);
+
+	top = h->root;
+	if (top != NULL) {
+		h->root = merge_pairs (h, top->child);
+		top->child = NULL;
+		h->size--;
+	}
+	return top;
+}
+
+/* Removes ELEM, which must be in heap H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *elem) {
+	struct heap_elem *sub;
+
+	ASSERT (h != NULL);
+	ASSERT (elem != NULL);
+
+	if (elem == h->root) {
+		heap_pop (h);
+		return;
+	}
+
+	/* Unlink ELEM from its parent or left sibling. */
+	ASSERT (elem->prev != NULL);
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+
+	/* Merge ELEM's subtrees back into the heap. */
+	sub = merge_pairs (h, elem->child);
+	elem->child = elem->next = elem->prev = NULL;
+	h->root = meld (h, h->root, sub);
+	h->size--;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (struct heap *h) {
+	ASSERT (h != NULL);
+	return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (struct heap *h) {
+	ASSERT (h != NULL);
+	return h->root == NULL;
+}
+
+/* Joins the trees rooted at A and B, either of which may be
+   null, and returns the new root.  A and B must not have
+   siblings.  On a tie A stays on top. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (h->less (b, a, h->aux)) {
+		struct heap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Merges the sibling list starting at FIRST into a single tree
+   and returns its root, or a null pointer if FIRST is null. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* Left to right: meld adjacent pairs, stacking the results
+	   on PAIRS through their `next' links. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL) {
+			b->next = b->prev = NULL;
+			a = meld (h, a, b);
+		}
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Right to left: fold the pairs into one tree. */
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->next;
+
+		pairs->next = NULL;
+		root = meld (h, pairs, root);
+		pairs = next;
+	}
+	return root;
+}
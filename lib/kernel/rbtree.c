@@ -0,0 +1,313 @@
+#include "rbtree.h"
+#include "../debug.h"
+
+/* A red-black tree is a binary search tree whose nodes are
+   colored so that no red node has a red child and every path
+   from a node down to a null leaf passes through the same number
+   of black nodes, which keeps its height within 2 lg (n + 1).
+   Insertion and removal restore these properties with at most
+   three rotations plus recoloring, following the algorithms in
+   [CLRS] chapter 13, adapted to null leaves. */
+
+static bool is_red (const struct rb_node *);
+static void replace_child (struct rbtree *,
+		struct rb_node *old, struct rb_node *new);
+static void rotate_left (struct rbtree *, struct rb_node *);
+static void rotate_right (struct rbtree *, struct rb_node *);
+static void insert_fixup (struct rbtree *, struct rb_node *);
+static void remove_fixup (struct rbtree *,
+		struct rb_node *, struct rb_node *parent);
+
+/* Initializes TREE as an empty tree ordered by LESS given
+   auxiliary data AUX. */
+void
+rbtree_init (struct rbtree *tree, rbtree_less_func *less, void *aux) {
+	ASSERT (tree != NULL);
+	ASSERT (less != NULL);
+
+	tree->root = tree->min = NULL;
+	tree->size = 0;
+	tree->less = less;
+	tree->aux = aux;
+}
+
+/* Inserts NODE into TREE, after any nodes that compare equal to
+   it. */
+void
+rbtree_insert (struct rbtree *tree, struct rb_node *node) {
+	struct rb_node **link = &tree->root;
+	struct rb_node *parent = NULL;
+	bool leftmost = true;
+
+	ASSERT (tree != NULL);
+	ASSERT (node != NULL);
+
+	while (*link != NULL) {
+		parent = *link;
+		if (tree->less (node, parent, tree->aux))
+			link = &parent->left;
+		else {
+			link = &parent->right;
+			leftmost = false;
+		}
+	}
+
+	node->parent = parent;
+	node->left = node->right = NULL;
+	node->red = true;
+	*link = node;
+	if (leftmost)
+		tree->min = node;
+	tree->size++;
+
+	insert_fixup (tree, node);
+}
+
+/* Removes NODE, which must be in TREE, from TREE. */
+void
+rbtree_remove (struct rbtree *tree, struct rb_node *node) {
+	struct rb_node *child, *parent;
+	bool red;
+
+	ASSERT (tree != NULL);
+	ASSERT (node != NULL);
+
+	if (tree->min == node)
+		tree->min = rbtree_next (node);
+
+	if (node->left != NULL && node->right != NULL) {
+		/* Move NODE's successor, which has no left child, into
+		   NODE's place, and fix up from where the successor was. */
+		struct rb_node *succ = node->right;
+
+		while (succ->left != NULL)
+			succ = succ->left;
+		child = succ->right;
+		parent = succ->parent;
+		red = succ->red;
+
+		if (parent == node)
+			parent = succ;
+		else {
+			parent->left = child;
+			if (child != NULL)
+				child->parent = parent;
+			succ->right = node->right;
+			node->right->parent = succ;
+		}
+
+		replace_child (tree, node, succ);
+		succ->parent = node->parent;
+		succ->left = node->left;
+		node->left->parent = succ;
+		succ->red = node->red;
+	} else {
+		child = node->left != NULL ? node->left : node->right;
+		parent = node->parent;
+		red = node->red;
+
+		if (child != NULL)
+			child->parent = parent;
+		replace_child (tree, node, child);
+	}
+
+	tree->size--;
+	if (!red)
+		remove_fixup (tree, child, parent);
+}
+
+/* Returns the least node in TREE, or a null pointer if TREE is
+   empty. */
+struct rb_node *
+rbtree_min (struct rbtree *tree) {
+	ASSERT (tree != NULL);
+	return tree->min;
+}
+
+/* Returns the node that follows NODE in its tree, or a null
+   pointer if NODE is the greatest. */
+struct rb_node *
+rbtree_next (struct rb_node *node) {
+	ASSERT (node != NULL);
+
+	if (node->right != NULL) {
+		node = node->right;
+		while (node->left != NULL)
+			node = node->left;
+		return node;
+	}
+	while (node->parent != NULL && node == node->parent->right)
+		node = node->parent;
+	return node->parent;
+}
+
+/* Returns the number of nodes in TREE. */
+size_t
+rbtree_size (struct rbtree *tree) {
+	ASSERT (tree != NULL);
+	return tree->size;
+}
+
+/* Returns true if TREE is empty, false otherwise. */
+bool
+rbtree_empty (struct rbtree *tree) {
+	ASSERT (tree != NULL);
+	return tree->root == NULL;
+}
+
+/* Returns true if NODE is red.  Null leaves are black. */
+static bool
+is_red (const struct rb_node *node) {
+	return node != NULL && node->red;
+}
+
+/* Makes NEW take OLD's place as a child of OLD's parent, or as
+   the root of TREE. */
+static void
+replace_child (struct rbtree *tree, struct rb_node *old, struct rb_node *new) {
+	if (old->parent == NULL)
+		tree->root = new;
+	else if (old == old->parent->left)
+		old->parent->left = new;
+	else
+		old->parent->right = new;
+}
+
+/* Rotates NODE's right child up into NODE's place. */
+static void
+rotate_left (struct rbtree *tree, struct rb_node *node) {
+	struct rb_node *up = node->right;
+
+	node->right = up->left;
+	if (up->left != NULL)
+		up->left->parent = node;
+	replace_child (tree, node, up);
+	up->parent = node->parent;
+	up->left = node;
+	node->parent = up;
+}
+
+/* Rotates NODE's left child up into NODE's place. */
+static void
+rotate_right (struct rbtree *tree, struct rb_node *node) {
+	struct rb_node *up = node->left;
+
+	node->left = up->right;
+	if (up->right != NULL)
+		up->right->parent = node;
+	replace_child (tree, node, up);
+	up->parent = node->parent;
+	up->right = node;
+	node->parent = up;
+}
+
+/* Restores the red-black properties after red NODE was
+   inserted. */
+static void
+insert_fixup (struct rbtree *tree, struct rb_node *node) {
+	while (is_red (node->parent)) {
+		struct rb_node *parent = node->parent;
+		struct rb_node *grand = parent->parent;
+
+		if (parent == grand->left) {
+			struct rb_node *uncle = grand->right;
+
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grand->red = true;
+				node = grand;
+				continue;
+			}
+			if (node == parent->right) {
+				rotate_left (tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = false;
+			grand->red = true;
+			rotate_right (tree, grand);
+		} else {
+			struct rb_node *uncle = grand->left;
+
+			if (is_red (uncle)) {
+				parent->red = uncle->red = false;
+				grand->red = true;
+				node = grand;
+				continue;
+			}
+			if (node == parent->left) {
+				rotate_right (tree, parent);
+				node = parent;
+				parent = node->parent;
+			}
+			parent->red = false;
+			grand->red = true;
+			rotate_left (tree, grand);
+		}
+	}
+	tree->root->red = false;
+}
+
+/* Restores the red-black properties after a black node was
+   removed, leaving NODE, which may be null, one black short below
+   PARENT. */
+static void
+remove_fixup (struct rbtree *tree, struct rb_node *node,
+		struct rb_node *parent) {
+	while (node != tree->root && !is_red (node)) {
+		if (node == parent->left) {
+			struct rb_node *sib = parent->right;
+
+			if (is_red (sib)) {
+				sib->red = false;
+				parent->red = true;
+				rotate_left (tree, parent);
+				sib = parent->right;
+			}
+			if (!is_red (sib->left) && !is_red (sib->right)) {
+				sib->red = true;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!is_red (sib->right)) {
+				sib->left->red = false;
+				sib->red = true;
+				rotate_right (tree, sib);
+				sib = parent->right;
+			}
+			sib->red = parent->red;
+			parent->red = false;
+			sib->right->red = false;
+			rotate_left (tree, parent);
+		} else {
+			struct rb_node *sib = parent->left;
+
+			if (is_red (sib)) {
+				sib->red = false;
+				parent->red = true;
+				rotate_right (tree, parent);
+				sib = parent->left;
+			}
+			if (!is_red (sib->left) && !is_red (sib->right)) {
+				sib->red = true;
+				node = parent;
+				parent = node->parent;
+				continue;
+			}
+			if (!is_red (sib->left)) {
+				sib->right->red = false;
+				sib->red = true;
+				rotate_left (tree, sib);
+				sib = parent->left;
+			}
+			sib->red = parent->red;
+			parent->red = false;
+			sib->left->red = false;
+			rotate_right (tree, parent);
+		}
+		node = tree->root;
+	}
+	if (node != NULL)
+		node->red = false;
+}
@@ -0,0 +1,57 @@
+/* Sleeps repeatedly for 50 us, 500 us, and 5 ms, all shorter than
+   a timer tick, and measures each sleep against the TSC clock.
+   Fails if any sleep ends before its deadline; reports how late
+   the wakeups were on average and at worst. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUNDS 20               /* Sleeps per duration. */
+
+static void measure (int64_t us);
+
+void
+test_alarm_hrtimer (void)
+{
+  measure (50);
+  measure (500);
+  measure (5000);
+  pass ();
+}
+
+/* Sleeps ROUNDS times for US microseconds each. */
+static void
+measure (int64_t us)
+{
+  int64_t total = 0, worst = 0;
+  int early_cnt = 0;
+  int i;
+
+  for (i = 0; i < ROUNDS; i++)
+    {
+      int64_t start = timer_now_ns ();
+      int64_t late;
+
+      timer_usleep (us);
+      late = timer_now_ns () - start - us * 1000;
+      if (late < 0)
+        early_cnt++;
+      else
+        {
+          total += late;
+          if (late > worst)
+            worst = late;
+        }
+    }
+
+  if (early_cnt != 0)
+    fail ("%d of %d sleeps of %"PRId64" us woke early",
+          early_cnt, ROUNDS, us);
+  msg ("%d sleeps of %"PRId64" us: none early.", ROUNDS, us);
+  msg ("jitter: mean %"PRId64" ns, max %"PRId64" ns.",
+       total / ROUNDS, worst);
+}
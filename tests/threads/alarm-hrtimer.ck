@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# Jitter depends on the host, so it is reported but not checked.
+@output = grep (!/jitter:/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(alarm-hrtimer) begin
+(alarm-hrtimer) 20 sleeps of 50 us: none early.
+(alarm-hrtimer) 20 sleeps of 500 us: none early.
+(alarm-hrtimer) 20 sleeps of 5000 us: none early.
+(alarm-hrtimer) end
+EOF
+pass;
@@ -0,0 +1,127 @@
+/* Creates 10,000 threads that each sleep until a different,
+   staggered deadline, then verifies that every thread woke at or
+   after its deadline and that threads were woken in deadline
+   order.  Exercises the sleep queue with a large population so
+   that a linear scan in the timer interrupt would show.
+
+   Every thread is alive at once and needs its own page, so the
+   test is run with enough memory for 10,000 pages of kernel
+   pool (see Make.tests). */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 10000        /* Number of sleeping threads. */
+#define SPREAD 500              /* Deadlines span this many ticks. */
+#define SLACK 200               /* Ticks to create all the threads. */
+
+/* Information about the test. */
+struct stress_test
+  {
+    int64_t start;              /* Deadlines are relative to this. */
+    int64_t last_deadline;      /* Deadline of the last thread to wake. */
+    int asleep_cnt;             /* Threads that have gone to sleep. */
+    int early_cnt;              /* Threads that woke too early. */
+    int order_cnt;              /* Threads that woke out of order. */
+    struct semaphore done;      /* Upped by each thread on wakeup. */
+  };
+
+/* Information about an individual thread. */
+struct stress_thread
+  {
+    struct stress_test *test;   /* Info shared between all threads. */
+    int64_t deadline;           /* Tick to sleep until. */
+  };
+
+static void sleeper (void *);
+
+void
+test_alarm_stress (void)
+{
+  struct stress_test test;
+  struct stress_thread *threads;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  threads = malloc (sizeof *threads * THREAD_CNT);
+  if (threads == NULL)
+    PANIC ("couldn't allocate memory for test");
+
+  msg ("Creating %d threads with deadlines spread over %d ticks.",
+       THREAD_CNT, SPREAD);
+
+  /* Leave enough slack for every thread to be created and to go
+     to sleep before the first deadline passes. */
+  test.start = timer_ticks () + SLACK;
+  test.last_deadline = 0;
+  test.asleep_cnt = 0;
+  test.early_cnt = 0;
+  test.order_cnt = 0;
+  sema_init (&test.done, 0);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct stress_thread *t = &threads[i];
+      char name[16];
+
+      t->test = &test;
+      t->deadline = test.start + (i * 7919) % SPREAD;
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, t) == TID_ERROR)
+        fail ("thread_create() failed for thread %d", i);
+    }
+
+  /* Deadlines that passed before their thread went to sleep would
+     make the order check meaningless. */
+  while (test.asleep_cnt < THREAD_CNT)
+    thread_yield ();
+  if (timer_ticks () >= test.start)
+    fail ("creating %d threads took more than %d ticks",
+          THREAD_CNT, SLACK);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&test.done);
+
+  if (test.early_cnt != 0)
+    fail ("%d threads woke before their deadline", test.early_cnt);
+  if (test.order_cnt != 0)
+    fail ("%d threads woke out of deadline order", test.order_cnt);
+  msg ("All %d threads woke in deadline order.", THREAD_CNT);
+
+  free (threads);
+  pass ();
+}
+
+/* Sleeper thread. */
+static void
+sleeper (void *t_)
+{
+  struct stress_thread *t = t_;
+  struct stress_test *test = t->test;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  test->asleep_cnt++;
+  intr_set_level (old_level);
+  timer_sleep (t->deadline - timer_ticks ());
+
+  /* Woken threads at equal priority run in the order they were
+     unblocked, so deadlines must never go backwards here. */
+  old_level = intr_disable ();
+  if (timer_ticks () < t->deadline)
+    test->early_cnt++;
+  if (t->deadline < test->last_deadline)
+    test->order_cnt++;
+  test->last_deadline = t->deadline;
+  intr_set_level (old_level);
+
+  sema_up (&test->done);
+}
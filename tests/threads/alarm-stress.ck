@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-stress) begin
+(alarm-stress) Creating 10000 threads with deadlines spread over 500 ticks.
+(alarm-stress) All 10000 threads woke in deadline order.
+(alarm-stress) end
+EOF
+pass;
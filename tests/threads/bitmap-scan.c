@@ -0,0 +1,88 @@
+/* Times bitmap_scan() over a 1M-bit bitmap filled at random to
+   various levels, looking for runs of free bits of various
+   lengths from random starting points.  Each result is checked
+   against a bit-by-bit search and the average time per scan is
+   reported. */
+
+#include <bitmap.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "devices/timer.h"
+
+#define BIT_CNT (1024 * 1024)   /* Size of the bitmap. */
+#define SCAN_CNT 1000           /* Scans per case. */
+
+/* Fill level, in percent, and length of run to look for. */
+struct scan_case
+  {
+    int fill;
+    size_t cnt;
+  };
+
+static const struct scan_case cases[] =
+  {
+    {0, 1}, {50, 1}, {50, 8}, {90, 1}, {90, 4}, {99, 1},
+  };
+
+/* Too big for the stack. */
+static size_t starts[SCAN_CNT], found[SCAN_CNT];
+
+static size_t slow_scan (const struct bitmap *, size_t start, size_t cnt);
+
+void
+test_bitmap_scan (void)
+{
+  struct bitmap *b;
+  size_t i, c;
+
+  b = bitmap_create (BIT_CNT);
+  if (b == NULL)
+    fail ("couldn't allocate bitmap");
+  random_init (0);
+
+  for (c = 0; c < sizeof cases / sizeof *cases; c++)
+    {
+      const struct scan_case *sc = &cases[c];
+      int64_t start_time, elapsed;
+
+      for (i = 0; i < BIT_CNT; i++)
+        bitmap_set (b, i, random_ulong () % 100 < (unsigned long) sc->fill);
+      for (i = 0; i < SCAN_CNT; i++)
+        starts[i] = random_ulong () % BIT_CNT;
+
+      start_time = timer_now_ns ();
+      for (i = 0; i < SCAN_CNT; i++)
+        found[i] = bitmap_scan (b, starts[i], sc->cnt, false);
+      elapsed = timer_now_ns () - start_time;
+
+      for (i = 0; i < SCAN_CNT; i++)
+        if (found[i] != slow_scan (b, starts[i], sc->cnt))
+          fail ("fill %d%%, run of %zu from %zu: got %zu, expected %zu",
+                sc->fill, sc->cnt, starts[i], found[i],
+                slow_scan (b, starts[i], sc->cnt));
+      msg ("Fill %d%%, runs of %zu: all scans correct.", sc->fill, sc->cnt);
+      msg ("rate: %"PRId64" ns/scan.", elapsed / SCAN_CNT);
+    }
+
+  bitmap_destroy (b);
+}
+
+/* Returns the first run of CNT false bits in B at or after
+   START, testing one bit at a time. */
+static size_t
+slow_scan (const struct bitmap *b, size_t start, size_t cnt)
+{
+  size_t run = 0;
+  size_t i;
+
+  for (i = start; i < bitmap_size (b); i++)
+    {
+      run = bitmap_test (b, i) ? 0 : run + 1;
+      if (run == cnt)
+        return i + 1 - cnt;
+    }
+  return BITMAP_ERROR;
+}
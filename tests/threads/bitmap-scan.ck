@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, \@output, [<<'EOF']);
+(bitmap-scan) begin
+(bitmap-scan) Fill 0%, runs of 1: all scans correct.
+(bitmap-scan) Fill 50%, runs of 1: all scans correct.
+(bitmap-scan) Fill 50%, runs of 8: all scans correct.
+(bitmap-scan) Fill 90%, runs of 1: all scans correct.
+(bitmap-scan) Fill 90%, runs of 4: all scans correct.
+(bitmap-scan) Fill 99%, runs of 1: all scans correct.
+(bitmap-scan) end
+EOF
+pass;
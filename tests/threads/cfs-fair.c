@@ -0,0 +1,90 @@
+/* Checks that the fair-share scheduler ("-cfs") divides the CPU
+   in proportion to thread weights.
+
+   Three threads spin for 10 seconds: two at PRI_DEFAULT, whose
+   weight is 1024, and one at PRI_DEFAULT + 5, which counts as
+   nice -5 and weighs 3121.  They should receive about 20%, 20%
+   and 60% of the ticks; each share must be within 5 percentage
+   points of that. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 3
+#define SLEEP_TICKS (1 * TIMER_FREQ)    /* Settle before spinning. */
+#define SPIN_TICKS (10 * TIMER_FREQ)    /* Length of the measurement. */
+#define TOLERANCE 5                     /* Percentage points. */
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+  };
+
+static void load_thread (void *aux);
+
+void
+test_cfs_fair (void)
+{
+  static const int priorities[THREAD_CNT] =
+    {PRI_DEFAULT, PRI_DEFAULT, PRI_DEFAULT + 5};
+  static const int expected[THREAD_CNT] = {20, 20, 60};
+  struct thread_info info[THREAD_CNT];
+  int64_t start_time;
+  int total = 0;
+  int i;
+
+  ASSERT (thread_cfs);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d threads...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+
+      info[i].start_time = start_time;
+      info[i].tick_count = 0;
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, priorities[i], load_thread, &info[i]);
+    }
+
+  timer_sleep (SLEEP_TICKS + SPIN_TICKS + TIMER_FREQ
+               - timer_elapsed (start_time));
+
+  for (i = 0; i < THREAD_CNT; i++)
+    total += info[i].tick_count;
+  if (total == 0)
+    fail ("threads received no ticks");
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      int share = info[i].tick_count * 100 / total;
+
+      msg ("Thread %d share: %d%% (%d ticks).",
+           i, share, info[i].tick_count);
+      if (share < expected[i] - TOLERANCE || share > expected[i] + TOLERANCE)
+        fail ("thread %d received %d%% of the CPU, expected %d%%",
+              i, share, expected[i]);
+      msg ("Thread %d received about %d%% of the CPU.", i, expected[i]);
+    }
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t spin_time = SLEEP_TICKS + SPIN_TICKS;
+  int64_t last_time = 0;
+
+  timer_sleep (SLEEP_TICKS - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
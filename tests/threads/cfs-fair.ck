@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# Exact shares vary from run to run, so they are reported but
+# not compared; the test itself fails if one is out of range.
+@output = grep (!/share:/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(cfs-fair) begin
+(cfs-fair) Starting 3 threads...
+(cfs-fair) Thread 0 received about 20% of the CPU.
+(cfs-fair) Thread 1 received about 20% of the CPU.
+(cfs-fair) Thread 2 received about 60% of the CPU.
+(cfs-fair) end
+EOF
+pass;
@@ -0,0 +1,140 @@
+/* Runs several threads that each allocate and free blocks of
+   random sizes, stamping and checking every block, and yield
+   often so that their allocations interleave.  Reports the time
+   per allocate/free pair and, in kernels built with LOCKSTAT, how
+   often the malloc() descriptor locks were taken, which per-thread
+   magazines should keep well below once per call. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/lockstat.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 4            /* Number of allocating threads. */
+#define PAIR_CNT 5000           /* Allocate/free pairs per thread. */
+#define LIVE_CNT 32             /* Blocks each thread holds at once. */
+#define MAX_SIZE 2000           /* Largest request, in bytes. */
+
+/* An allocating thread. */
+struct allocator
+  {
+    int id;                     /* Thread number. */
+    unsigned seed;              /* Random state. */
+    char *blocks[LIVE_CNT];     /* Live blocks. */
+    size_t sizes[LIVE_CNT];     /* Their sizes. */
+    int bad_cnt;                /* Blocks found overwritten. */
+  };
+
+static struct allocator allocators[THREAD_CNT];
+static struct semaphore done;
+
+static thread_func allocate;
+static uint64_t malloc_acquisitions (void);
+
+void
+test_malloc_magazine (void)
+{
+  uint64_t acquired, start, ns;
+  int i, bad_cnt = 0;
+
+  sema_init (&done, 0);
+  acquired = malloc_acquisitions ();
+  start = timer_now_ns ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      struct allocator *a = &allocators[i];
+      char name[16];
+
+      a->id = i;
+      a->seed = i + 1;
+      snprintf (name, sizeof name, "allocator %d", i);
+      thread_create (name, PRI_DEFAULT, allocate, a);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  ns = timer_now_ns () - start;
+  acquired = malloc_acquisitions () - acquired;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    bad_cnt += allocators[i].bad_cnt;
+  if (bad_cnt != 0)
+    fail ("%d blocks were overwritten", bad_cnt);
+  msg ("%d threads made %d allocations each without overlap.",
+       THREAD_CNT, PAIR_CNT);
+
+  msg ("rate: %"PRIu64" ns per allocate/free pair",
+       ns / (THREAD_CNT * PAIR_CNT));
+#ifdef LOCKSTAT
+  msg ("share: %"PRIu64" malloc lock acquisitions for %d allocations",
+       acquired, THREAD_CNT * PAIR_CNT);
+  if (acquired >= THREAD_CNT * PAIR_CNT / 2)
+    fail ("malloc locks taken %"PRIu64" times for %d allocations",
+          acquired, THREAD_CNT * PAIR_CNT);
+#endif
+  pass ();
+}
+
+/* Returns a random number from A's generator. */
+static unsigned
+next_random (struct allocator *a)
+{
+  a->seed = a->seed * 1103515245 + 12345;
+  return a->seed >> 16;
+}
+
+/* Allocating thread. */
+static void
+allocate (void *a_)
+{
+  struct allocator *a = a_;
+  int i, j;
+
+  for (i = 0; i < PAIR_CNT + LIVE_CNT; i++)
+    {
+      int slot = next_random (a) % LIVE_CNT;
+
+      if (a->blocks[slot] != NULL)
+        {
+          for (j = 0; j < (int) a->sizes[slot]; j++)
+            if (a->blocks[slot][j] != (char) (a->id + slot))
+              {
+                a->bad_cnt++;
+                break;
+              }
+          free (a->blocks[slot]);
+          a->blocks[slot] = NULL;
+        }
+      if (i < PAIR_CNT)
+        {
+          a->sizes[slot] = next_random (a) % MAX_SIZE + 1;
+          a->blocks[slot] = malloc (a->sizes[slot]);
+          if (a->blocks[slot] == NULL)
+            fail ("allocator %d: out of memory", a->id);
+          memset (a->blocks[slot], a->id + slot, a->sizes[slot]);
+        }
+      if (i % 64 == 0)
+        thread_yield ();
+    }
+  for (i = 0; i < LIVE_CNT; i++)
+    free (a->blocks[i]);
+  sema_up (&done);
+}
+
+/* Returns the number of times the malloc() locks have been
+   acquired, or 0 without LOCKSTAT. */
+static uint64_t
+malloc_acquisitions (void)
+{
+#ifdef LOCKSTAT
+  struct lockstat *s = lockstat_lookup ("malloc");
+  return s != NULL ? s->acquired : 0;
+#else
+  return 0;
+#endif
+}
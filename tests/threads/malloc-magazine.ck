@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# Lock counts depend on the build, so they are reported but not
+# checked.
+@output = grep (!/share:/, @output);
+compare_output ("run", IGNORE_RATES => 1, \@output, [<<'EOF']);
+(malloc-magazine) begin
+(malloc-magazine) 4 threads made 5000 allocations each without overlap.
+(malloc-magazine) end
+EOF
+pass;
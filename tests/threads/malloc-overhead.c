@@ -0,0 +1,115 @@
+/* Allocates a synthetic mix of small, medium and large blocks
+   with malloc(), reports how much of the memory taken from the
+   page allocator went unused, and checks that it stays under a
+   bound that power-of-two size classes could not meet.  Then
+   checks that realloc() resizes blocks in place when they still
+   fit. */
+
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A range of request sizes and how many blocks to take from it. */
+struct size_range
+  {
+    size_t min, max;
+    int cnt;
+  };
+
+static const struct size_range mix[] =
+  {
+    {8, 64, 400},
+    {65, 256, 200},
+    {257, 600, 60},
+    {1000, 1400, 30},
+    {1800, 2040, 10},
+    {2500, 6000, 5},
+  };
+
+#define BLOCK_CNT (400 + 200 + 60 + 30 + 10 + 5)
+#define MAX_OVERHEAD 40         /* Percent of pages left unused. */
+
+/* Too big for the stack. */
+static void *blocks[BLOCK_CNT];
+
+static void check_realloc (void);
+
+void
+test_malloc_overhead (void)
+{
+  size_t requested = 0, free_before, page_cnt, overhead;
+  size_t r;
+  int i, n = 0;
+
+  random_init (0);
+  free_before = palloc_free_cnt (0);
+  for (r = 0; r < sizeof mix / sizeof *mix; r++)
+    for (i = 0; i < mix[r].cnt; i++)
+      {
+        size_t size = mix[r].min
+                      + random_ulong () % (mix[r].max - mix[r].min + 1);
+
+        blocks[n] = malloc (size);
+        if (blocks[n] == NULL)
+          fail ("couldn't allocate %zu bytes", size);
+        memset (blocks[n], 0x5a, size);
+        requested += size;
+        n++;
+      }
+  ASSERT (n == BLOCK_CNT);
+
+  page_cnt = free_before - palloc_free_cnt (0);
+  overhead = 100 - requested * 100 / (page_cnt * PGSIZE);
+  msg ("share: %zu bytes requested in %zu pages, %zu%% overhead",
+       requested, page_cnt, overhead);
+  if (overhead >= MAX_OVERHEAD)
+    fail ("overhead of %zu%% is not under %d%%", overhead, MAX_OVERHEAD);
+  msg ("Overhead under %d%%.", MAX_OVERHEAD);
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    free (blocks[i]);
+
+  check_realloc ();
+  pass ();
+}
+
+/* Checks that realloc() keeps blocks in place when the new size
+   still fits, and that a shrinking big block frees its tail. */
+static void
+check_realloc (void)
+{
+  size_t free_before;
+  char *p, *q;
+
+  p = malloc (520);
+  memset (p, 'x', 520);
+  q = realloc (p, 560);
+  if (q != p)
+    fail ("growing a 520-byte block to 560 bytes moved it");
+  if (q[519] != 'x')
+    fail ("realloc() lost the block's contents");
+  q = realloc (q, 100);
+  if (q != p)
+    fail ("shrinking a block moved it");
+  free (q);
+  msg ("Small blocks resize in place.");
+
+  p = malloc (3 * PGSIZE);
+  memset (p, 'y', 3 * PGSIZE);
+  free_before = palloc_free_cnt (0);
+  q = realloc (p, PGSIZE);
+  if (q != p)
+    fail ("shrinking a big block moved it");
+  if (palloc_free_cnt (0) != free_before + 2)
+    fail ("shrinking a big block from 4 pages to 2 freed %zu pages",
+          palloc_free_cnt (0) - free_before);
+  if (q[PGSIZE - 1] != 'y')
+    fail ("realloc() lost the block's contents");
+  free (q);
+  msg ("Big blocks shrink in place.");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+# The exact figures depend on what else the kernel has allocated,
+# so they are reported but not checked.
+@output = grep (!/share:/, @output);
+compare_output ("run", \@output, [<<'EOF']);
+(malloc-overhead) begin
+(malloc-overhead) Overhead under 40%.
+(malloc-overhead) Small blocks resize in place.
+(malloc-overhead) Big blocks shrink in place.
+(malloc-overhead) end
+EOF
+pass;
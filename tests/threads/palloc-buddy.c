@@ -0,0 +1,122 @@
+/* Allocates page blocks of mixed sizes from the kernel pool,
+   stamps every page with its block's number and checks the
+   stamps after each round, so that blocks handed out twice or
+   overlapping show up.  Half the blocks are freed and reallocated
+   with other sizes each round to exercise splitting and
+   coalescing, and the average time per allocate/free pair is
+   reported.  Freeing everything at the end must leave the pool
+   with as many free pages, and as large a free block, as it had
+   before the test. */
+
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define BLOCK_CNT 64            /* Blocks held at once. */
+#define MAX_PAGES 9             /* Largest block, in pages. */
+#define ROUND_CNT 50            /* Rounds of freeing and reallocating. */
+
+/* A block of pages. */
+struct block
+  {
+    uint64_t *pages;
+    size_t page_cnt;
+  };
+
+static struct block blocks[BLOCK_CNT];
+
+static void alloc_block (int i);
+static void free_block (int i);
+static int check_blocks (void);
+
+void
+test_palloc_buddy (void)
+{
+  uint64_t start, ns;
+  long pair_cnt = 0;
+  size_t free_before;
+  int order_before;
+  int round, i;
+
+  random_init (0);
+  free_before = palloc_free_cnt (0);
+  order_before = palloc_largest_order (0);
+  for (i = 0; i < BLOCK_CNT; i++)
+    alloc_block (i);
+
+  start = timer_now_ns ();
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      for (i = round % 2; i < BLOCK_CNT; i += 2)
+        {
+          free_block (i);
+          alloc_block (i);
+          pair_cnt++;
+        }
+      if (check_blocks () != 0)
+        fail ("round %d: blocks overlap", round);
+    }
+  ns = timer_now_ns () - start;
+  msg ("%d rounds of %d blocks: no overlap.", ROUND_CNT, BLOCK_CNT);
+  msg ("rate: %"PRIu64" ns per allocate/free pair", ns / pair_cnt);
+
+  /* Once everything is freed, the pieces must have merged back
+     into blocks as large as the pool had before the test. */
+  for (i = 0; i < BLOCK_CNT; i++)
+    free_block (i);
+  if (palloc_free_cnt (0) != free_before)
+    fail ("%zu free pages before the test, %zu after",
+          free_before, palloc_free_cnt (0));
+  if (palloc_largest_order (0) != order_before)
+    fail ("largest free order %d before the test, %d after",
+          order_before, palloc_largest_order (0));
+  msg ("Freed blocks coalesced.");
+  pass ();
+}
+
+/* Allocates block I with a random size and stamps its pages. */
+static void
+alloc_block (int i)
+{
+  struct block *b = &blocks[i];
+  size_t p;
+
+  b->page_cnt = random_ulong () % MAX_PAGES + 1;
+  b->pages = palloc_get_multiple (0, b->page_cnt);
+  if (b->pages == NULL)
+    fail ("couldn't allocate %zu pages for block %d", b->page_cnt, i);
+  for (p = 0; p < b->page_cnt; p++)
+    b->pages[p * PGSIZE / sizeof *b->pages] = i;
+}
+
+/* Frees block I. */
+static void
+free_block (int i)
+{
+  palloc_free_multiple (blocks[i].pages, blocks[i].page_cnt);
+  blocks[i].pages = NULL;
+}
+
+/* Returns the number of pages whose stamp was overwritten. */
+static int
+check_blocks (void)
+{
+  int bad = 0;
+  int i;
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      struct block *b = &blocks[i];
+      size_t p;
+
+      for (p = 0; p < b->page_cnt; p++)
+        if (b->pages[p * PGSIZE / sizeof *b->pages] != (uint64_t) i)
+          bad++;
+    }
+  return bad;
+}
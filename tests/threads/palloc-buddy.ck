@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, \@output, [<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) 50 rounds of 64 blocks: no overlap.
+(palloc-buddy) Freed blocks coalesced.
+(palloc-buddy) end
+EOF
+pass;
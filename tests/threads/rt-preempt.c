@@ -0,0 +1,67 @@
+/* Ensures that a real-time thread preempts normal threads
+   whatever their priority, and that a SCHED_FIFO thread is not
+   time-sliced.
+
+   A SCHED_FIFO thread at PRI_MIN blocks and is woken by the main
+   thread at PRI_DEFAULT, which it must preempt at once.  It then
+   spins for several time slices, during which the main thread
+   must not run, and creates a normal thread at PRI_MAX, which
+   must not run until the real-time thread is done. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SPIN_TICKS 10
+
+static struct semaphore ready, wake;
+static volatile bool main_ran;
+
+static thread_func rt_thread_func;
+static thread_func high_thread_func;
+
+void
+test_rt_preempt (void)
+{
+  ASSERT (thread_get_policy () == SCHED_OTHER);
+
+  sema_init (&ready, 0);
+  sema_init (&wake, 0);
+  thread_create ("rt", PRI_MIN, rt_thread_func, NULL);
+  sema_down (&ready);
+
+  msg ("Waking the real-time thread.");
+  sema_up (&wake);
+  main_ran = true;
+  msg ("Main resumed.");
+}
+
+static void
+rt_thread_func (void *aux UNUSED)
+{
+  int64_t start;
+
+  thread_set_policy (SCHED_FIFO);
+  sema_up (&ready);
+  sema_down (&wake);
+  msg ("Real-time thread woke.");
+
+  start = timer_ticks ();
+  while (timer_elapsed (start) < SPIN_TICKS)
+    continue;
+  if (main_ran)
+    fail ("main thread ran while the real-time thread spun");
+  msg ("Real-time thread spun for %d ticks without preemption.", SPIN_TICKS);
+
+  thread_create ("high", PRI_MAX, high_thread_func, NULL);
+  msg ("Real-time thread done.");
+}
+
+static void
+high_thread_func (void *aux UNUSED)
+{
+  msg ("Thread %s ran.", thread_name ());
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rt-preempt) begin
+(rt-preempt) Waking the real-time thread.
+(rt-preempt) Real-time thread woke.
+(rt-preempt) Real-time thread spun for 10 ticks without preemption.
+(rt-preempt) Real-time thread done.
+(rt-preempt) Thread high ran.
+(rt-preempt) Main resumed.
+(rt-preempt) end
+EOF
+pass;
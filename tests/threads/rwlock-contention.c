@@ -0,0 +1,101 @@
+/* Checks the reader-writer lock under contention.
+
+   First, several readers take the lock and each waits until all
+   of them are inside at once, which can only happen if readers
+   do not serialize.  Then, with the main thread holding the lock
+   for reading, a writer waits for it and a higher-priority reader
+   arrives after the writer: the late reader must wait behind the
+   writer, and the writer must run with the late reader's donated
+   priority. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define READER_CNT 4            /* Number of concurrent readers. */
+#define PATIENCE 100            /* Ticks a reader waits for the others. */
+
+static struct rwlock rw;
+static struct semaphore done;
+static int inside;              /* Readers currently holding RW. */
+static int max_inside;          /* Most readers ever inside at once. */
+
+static thread_func reader;
+static thread_func writer;
+static thread_func late_reader;
+
+void
+test_rwlock_contention (void)
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  sema_init (&done, 0);
+
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT, reader, NULL);
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&done);
+  if (max_inside != READER_CNT)
+    fail ("only %d of %d readers held the lock at once",
+          max_inside, READER_CNT);
+  msg ("%d readers held the lock at once.", max_inside);
+
+  rwlock_acquire_read (&rw);
+  thread_create ("writer", PRI_DEFAULT + 1, writer, NULL);
+  thread_create ("late reader", PRI_DEFAULT + 2, late_reader, NULL);
+  msg ("Main releasing read lock.");
+  rwlock_release_read (&rw);
+  msg ("Main done.");
+}
+
+/* Holds RW for reading until every reader is inside, or until it
+   has waited PATIENCE ticks. */
+static void
+reader (void *aux UNUSED)
+{
+  enum intr_level old_level;
+  int i;
+
+  rwlock_acquire_read (&rw);
+  old_level = intr_disable ();
+  if (++inside > max_inside)
+    max_inside = inside;
+  intr_set_level (old_level);
+
+  for (i = 0; i < PATIENCE && max_inside < READER_CNT; i++)
+    timer_sleep (1);
+
+  old_level = intr_disable ();
+  inside--;
+  intr_set_level (old_level);
+  rwlock_release_read (&rw);
+  sema_up (&done);
+}
+
+static void
+writer (void *aux UNUSED)
+{
+  rwlock_acquire_write (&rw);
+  msg ("Writer got the lock at priority %d.", thread_get_priority ());
+  rwlock_release_write (&rw);
+  msg ("Writer done.");
+}
+
+static void
+late_reader (void *aux UNUSED)
+{
+  rwlock_acquire_read (&rw);
+  msg ("Late reader got the lock.");
+  rwlock_release_read (&rw);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-contention) begin
+(rwlock-contention) 4 readers held the lock at once.
+(rwlock-contention) Main releasing read lock.
+(rwlock-contention) Writer got the lock at priority 33.
+(rwlock-contention) Late reader got the lock.
+(rwlock-contention) Writer done.
+(rwlock-contention) Main done.
+(rwlock-contention) end
+EOF
+pass;
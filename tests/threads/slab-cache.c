@@ -0,0 +1,169 @@
+/* Allocates objects of several sizes from object caches, stamps
+   and checks them so that objects handed out twice or
+   overlapping show up, and checks that a cache's constructor runs
+   once per object.  Reports how many objects fit in a page and
+   the average time per allocate/free pair for a cache and for
+   malloc(). */
+
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define OBJ_CNT 256             /* Objects allocated at once. */
+#define ROUND_CNT 20            /* Timed rounds. */
+
+/* Object sizes to try: small, odd, and just over half a kB like a
+   struct inode. */
+static const size_t sizes[] = {24, 120, 540};
+
+/* Too big for the stack. */
+static void *objs[OBJ_CNT];
+static void *pages[OBJ_CNT];
+
+static int ctor_cnt;
+
+static void *cache_alloc (void *c, size_t size);
+static void cache_free (void *c, void *p);
+static void *malloc_alloc (void *c, size_t size);
+static void malloc_free (void *c, void *p);
+static size_t stamp_and_check (void *(*alloc) (void *, size_t),
+                               void (*release) (void *, void *),
+                               void *c, size_t size);
+static uint64_t time_rounds (void *(*alloc) (void *, size_t),
+                             void (*release) (void *, void *),
+                             void *c, size_t size);
+static void count_ctor (void *);
+
+void
+test_slab_cache (void)
+{
+  struct kmem_cache *c;
+  size_t i, per_slab;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    {
+      size_t size = sizes[i];
+      size_t cache_per_page, malloc_per_page;
+      uint64_t cache_ns, malloc_ns;
+
+      c = kmem_cache_create ("slab-cache", size, NULL);
+      cache_per_page = stamp_and_check (cache_alloc, cache_free, c, size);
+      malloc_per_page = stamp_and_check (malloc_alloc, malloc_free, NULL, size);
+      msg ("%zu-byte objects: no overlap.", size);
+
+      cache_ns = time_rounds (cache_alloc, cache_free, c, size);
+      malloc_ns = time_rounds (malloc_alloc, malloc_free, NULL, size);
+      msg ("rate: %zu-byte objects: cache %zu per page, %"PRIu64" ns; "
+           "malloc %zu per page, %"PRIu64" ns per allocate/free pair",
+           size, cache_per_page, cache_ns, malloc_per_page, malloc_ns);
+    }
+
+  /* The constructor runs when a slab is created, not on every
+     allocation. */
+  c = kmem_cache_create ("slab-cache ctor", 40, count_ctor);
+  per_slab = kmem_cache_objs_per_slab (c);
+  for (i = 0; i < OBJ_CNT; i++)
+    objs[i] = kmem_cache_alloc (c);
+  if (ctor_cnt != (int) (DIV_ROUND_UP (OBJ_CNT, per_slab) * per_slab))
+    fail ("constructor ran %d times for %d objects", ctor_cnt, OBJ_CNT);
+  for (i = 0; i < OBJ_CNT; i++)
+    kmem_cache_free (c, objs[i]);
+  msg ("Constructor ran once per object.");
+  pass ();
+}
+
+/* Allocates OBJ_CNT SIZE-byte objects with ALLOC, fills each with
+   its own byte, checks them all, and frees them with RELEASE.
+   Returns the average number of objects per page used. */
+static size_t
+stamp_and_check (void *(*alloc) (void *, size_t),
+                 void (*release) (void *, void *), void *c, size_t size)
+{
+  size_t page_cnt = 0;
+  size_t i, j;
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      void *page;
+
+      objs[i] = alloc (c, size);
+      if (objs[i] == NULL)
+        fail ("couldn't allocate %zu-byte object %zu", size, i);
+      memset (objs[i], i & 0xff, size);
+
+      page = pg_round_down (objs[i]);
+      for (j = 0; j < page_cnt; j++)
+        if (pages[j] == page)
+          break;
+      if (j == page_cnt)
+        pages[page_cnt++] = page;
+    }
+
+  for (i = 0; i < OBJ_CNT; i++)
+    {
+      const uint8_t *p = objs[i];
+
+      for (j = 0; j < size; j++)
+        if (p[j] != (i & 0xff))
+          fail ("%zu-byte object %zu was overwritten", size, i);
+      release (c, objs[i]);
+    }
+  return OBJ_CNT / page_cnt;
+}
+
+/* Returns the average time, in nanoseconds, to allocate and free
+   a SIZE-byte object with ALLOC and RELEASE. */
+static uint64_t
+time_rounds (void *(*alloc) (void *, size_t),
+             void (*release) (void *, void *), void *c, size_t size)
+{
+  int64_t start = timer_now_ns ();
+  int round;
+  size_t i;
+
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      for (i = 0; i < OBJ_CNT; i++)
+        objs[i] = alloc (c, size);
+      for (i = 0; i < OBJ_CNT; i++)
+        release (c, objs[i]);
+    }
+  return (timer_now_ns () - start) / (ROUND_CNT * OBJ_CNT);
+}
+
+static void *
+cache_alloc (void *c, size_t size UNUSED)
+{
+  return kmem_cache_alloc (c);
+}
+
+static void
+cache_free (void *c, void *p)
+{
+  kmem_cache_free (c, p);
+}
+
+static void *
+malloc_alloc (void *c UNUSED, size_t size)
+{
+  return malloc (size);
+}
+
+static void
+malloc_free (void *c UNUSED, void *p)
+{
+  free (p);
+}
+
+static void
+count_ctor (void *obj UNUSED)
+{
+  ctor_cnt++;
+}
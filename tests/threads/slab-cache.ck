@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, \@output, [<<'EOF']);
+(slab-cache) begin
+(slab-cache) 24-byte objects: no overlap.
+(slab-cache) 120-byte objects: no overlap.
+(slab-cache) 540-byte objects: no overlap.
+(slab-cache) Constructor ran once per object.
+(slab-cache) end
+EOF
+pass;
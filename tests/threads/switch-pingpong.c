@@ -0,0 +1,53 @@
+/* Passes control back and forth between two threads through a
+   pair of semaphores, as sema_self_test() does, and reports how
+   many context switches per second that achieves.  Each round
+   trip blocks each thread once, so it costs two switches. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUND_CNT 20000         /* Number of round trips. */
+
+static thread_func pong;
+
+void
+test_switch_pingpong (void)
+{
+  struct semaphore sema[2];
+  int64_t start, elapsed;
+  int i;
+
+  sema_init (&sema[0], 0);
+  sema_init (&sema[1], 0);
+  thread_create ("pong", PRI_DEFAULT, pong, &sema);
+
+  start = timer_now_ns ();
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_up (&sema[0]);
+      sema_down (&sema[1]);
+    }
+  elapsed = timer_now_ns () - start;
+
+  msg ("Completed %d round trips.", ROUND_CNT);
+  msg ("rate: %"PRId64" switches/s.",
+       elapsed > 0 ? 2 * ROUND_CNT * (int64_t) 1000000000 / elapsed : 0);
+}
+
+static void
+pong (void *sema_)
+{
+  struct semaphore *sema = sema_;
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      sema_down (&sema[0]);
+      sema_up (&sema[1]);
+    }
+}
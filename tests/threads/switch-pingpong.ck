@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, \@output, [<<'EOF']);
+(switch-pingpong) begin
+(switch-pingpong) Completed 20000 round trips.
+(switch-pingpong) end
+EOF
+pass;
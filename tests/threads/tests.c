@@ -17,6 +17,8 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-stress", test_alarm_stress},
+    {"alarm-hrtimer", test_alarm_hrtimer},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -28,6 +30,16 @@ static const struct test tests[] =
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
+    {"rwlock-contention", test_rwlock_contention},
+    {"thread-churn", test_thread_churn},
+    {"cfs-fair", test_cfs_fair},
+    {"rt-preempt", test_rt_preempt},
+    {"switch-pingpong", test_switch_pingpong},
+    {"bitmap-scan", test_bitmap_scan},
+    {"palloc-buddy", test_palloc_buddy},
+    {"slab-cache", test_slab_cache},
+    {"malloc-overhead", test_malloc_overhead},
+    {"malloc-magazine", test_malloc_magazine},
 #ifdef DO_TEST_CONDVAR
     {"priority-condvar", test_priority_condvar},
 #endif
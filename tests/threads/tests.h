@@ -11,6 +11,8 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_stress;
+extern test_func test_alarm_hrtimer;
 extern test_func test_priority_change;
 extern test_func test_priority_donate_one;
 extern test_func test_priority_donate_multiple;
@@ -19,6 +21,16 @@ extern test_func test_priority_donate_sema;
 extern test_func test_priority_donate_nest;
 extern test_func test_priority_donate_lower;
 extern test_func test_priority_donate_chain;
+extern test_func test_rwlock_contention;
+extern test_func test_thread_churn;
+extern test_func test_cfs_fair;
+extern test_func test_rt_preempt;
+extern test_func test_switch_pingpong;
+extern test_func test_bitmap_scan;
+extern test_func test_palloc_buddy;
+extern test_func test_slab_cache;
+extern test_func test_malloc_overhead;
+extern test_func test_malloc_magazine;
 extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
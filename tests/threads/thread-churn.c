@@ -0,0 +1,60 @@
+/* Creates and joins many short-lived threads one after another
+   and reports how many it got through per second, first with the
+   thread page cache turned off, as before it existed, then with
+   it on.  Each thread is created only after the previous one has
+   exited, so with the cache every creation after the first few
+   reuses a recycled page. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 500          /* Number of threads to create. */
+
+static thread_func quick;
+static void churn (bool cache);
+
+void
+test_thread_churn (void)
+{
+  churn (false);
+  churn (true);
+}
+
+/* Creates and joins THREAD_CNT threads with the thread page cache
+   on if CACHE is true, off otherwise, and reports the rate. */
+static void
+churn (bool cache)
+{
+  struct semaphore done;
+  int64_t start, elapsed;
+  int i;
+
+  thread_cache_enabled = cache;
+  sema_init (&done, 0);
+  start = timer_now_ns ();
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      if (thread_create ("quick", PRI_DEFAULT, quick, &done) == TID_ERROR)
+        fail ("thread_create() failed for thread %d", i);
+      sema_down (&done);
+    }
+  elapsed = timer_now_ns () - start;
+  thread_cache_enabled = true;
+
+  msg ("Created and joined %d threads with the page cache %s.",
+       THREAD_CNT, cache ? "on" : "off");
+  msg ("rate: %"PRId64" threads/s with the page cache %s.",
+       elapsed > 0 ? THREAD_CNT * (int64_t) 1000000000 / elapsed : 0,
+       cache ? "on" : "off");
+}
+
+static void
+quick (void *done_)
+{
+  sema_up (done_);
+}
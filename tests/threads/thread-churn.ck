@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, \@output, [<<'EOF']);
+(thread-churn) begin
+(thread-churn) Created and joined 500 threads with the page cache off.
+(thread-churn) Created and joined 500 threads with the page cache on.
+(thread-churn) end
+EOF
+pass;
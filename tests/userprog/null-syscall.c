@@ -0,0 +1,29 @@
+/* Measures the round-trip cost of a system call that does next
+   to no work: filesize() on a file descriptor that is not open,
+   which only looks up the descriptor under the file system lock.
+   Reports the average in TSC cycles, read with rdtsc, which user
+   programs may execute. */
+
+#include <syscall.h>
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CALL_CNT 100000         /* Number of calls to time. */
+#define UNOPENED_FD 63          /* A descriptor that is never open. */
+
+void
+test_main (void)
+{
+  uint64_t start, cycles;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < CALL_CNT; i++)
+    if (filesize (UNOPENED_FD) != -1)
+      fail ("filesize() of an unopened fd succeeded");
+  cycles = rdtsc () - start;
+
+  msg ("Made %d system calls.", CALL_CNT);
+  msg ("rate: %llu cycles/call.", cycles / CALL_CNT);
+}
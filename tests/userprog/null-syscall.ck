@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, \@output, [<<'EOF']);
+(null-syscall) begin
+(null-syscall) Made 100000 system calls.
+(null-syscall) end
+null-syscall: exit(0)
+EOF
+pass;
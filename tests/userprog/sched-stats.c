@@ -0,0 +1,33 @@
+/* Checks the scheduler statistics returned by sched_stats().
+
+   Each time a thread is dispatched it has just finished a
+   run-queue wait, and each dispatch after its first follows a
+   switch away from it, so the number of waits in the histogram
+   must be one more than the number of context switches.  Writing
+   to the console gives the kernel a chance to switch a few
+   times first. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  struct sched_stats stats;
+  uint64_t waits = 0;
+  int i;
+
+  for (i = 0; i < 10; i++)
+    msg ("Line %d.", i);
+
+  CHECK (sched_stats (&stats) == 0, "sched_stats");
+  for (i = 0; i < SCHED_WAIT_BUCKETS; i++)
+    waits += stats.wait_hist[i];
+  if (waits != stats.voluntary + stats.involuntary + 1)
+    fail ("%llu waits but %llu context switches", waits,
+          stats.voluntary + stats.involuntary);
+  if (stats.wait_ns < 0)
+    fail ("negative run-queue wait %lld ns", stats.wait_ns);
+  msg ("Waits match context switches.");
+}
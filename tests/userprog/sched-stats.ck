@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-stats) begin
+(sched-stats) Line 0.
+(sched-stats) Line 1.
+(sched-stats) Line 2.
+(sched-stats) Line 3.
+(sched-stats) Line 4.
+(sched-stats) Line 5.
+(sched-stats) Line 6.
+(sched-stats) Line 7.
+(sched-stats) Line 8.
+(sched-stats) Line 9.
+(sched-stats) sched_stats
+(sched-stats) Waits match context switches.
+(sched-stats) end
+sched-stats: exit(0)
+EOF
+pass;
@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, IGNORE_EXIT_CODES => 1,
+		\@output, [<<'EOF']);
+(cow-fork-latency) begin
+(cow-fork-latency) fork with 1 MB resident
+(cow-fork-latency) child saw the parent's 1 MB
+(cow-fork-latency) parent's 1 MB unchanged
+(cow-fork-latency) fork with 16 MB resident
+(cow-fork-latency) child saw the parent's 16 MB
+(cow-fork-latency) parent's 16 MB unchanged
+(cow-fork-latency) fork with 64 MB resident
+(cow-fork-latency) child saw the parent's 64 MB
+(cow-fork-latency) parent's 64 MB unchanged
+(cow-fork-latency) end
+EOF
+pass;
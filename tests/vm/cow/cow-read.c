@@ -0,0 +1,39 @@
+/* Has a forked child read() a file into a buffer it still shares
+   copy-on-write with its parent.  The kernel, not the child,
+   stores into the buffer, so the write must still fault and give
+   the child its own copy.  The parent then checks that its copy
+   of the buffer is unchanged. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[4096] __attribute__ ((aligned (4096)));
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  memset (buf, 'x', sizeof buf);
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      int handle = open ("sample.txt");
+      int size = (int) strlen (sample);
+
+      if (handle < 2 || read (handle, buf, size) != size)
+        exit (1);
+      exit (memcmp (buf, sample, size) == 0 ? 0 : 2);
+    }
+  CHECK (child > 0, "fork");
+  CHECK (wait (child) == 0, "child read into its copy");
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 'x')
+      fail ("byte %zu of parent's buffer changed to %02hhx", i, buf[i]);
+  msg ("parent's copy unchanged");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-read) begin
+(cow-read) fork
+(cow-read) child read into its copy
+(cow-read) parent's copy unchanged
+(cow-read) end
+EOF
+pass;
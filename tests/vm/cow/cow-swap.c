@@ -0,0 +1,52 @@
+/* Forks while most of the parent's 12 MB of anonymous memory is
+   swapped out, in 10 MB of RAM.  The child shares the parent's
+   swap slots rather than having them read back in for the fork.
+   It checks that it sees the parent's data and changes every
+   page; the parent then checks that its own copy is unchanged. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (12 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+/* Returns true if every page of BIG_CHUNKS holds its index plus
+   DELTA. */
+static bool
+intact (int delta)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunks[i * PAGE_SIZE] != (char) (i + delta))
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunks[i * PAGE_SIZE] = (char) i;
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      if (!intact (0))
+        exit (1);
+      for (i = 0; i < PAGE_COUNT; i++)
+        big_chunks[i * PAGE_SIZE]++;
+      exit (intact (1) ? 0 : 2);
+    }
+  CHECK (child > 0, "fork");
+  CHECK (wait (child) == 0, "child saw and changed its copy");
+  CHECK (intact (0), "parent's copy unchanged");
+}
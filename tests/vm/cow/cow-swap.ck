@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-swap) begin
+(cow-swap) fork
+(cow-swap) child saw and changed its copy
+(cow-swap) parent's copy unchanged
+(cow-swap) end
+EOF
+pass;
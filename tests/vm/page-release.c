@@ -0,0 +1,54 @@
+/* Forks eight children in turn that each fill 64 MB of memory and
+   exit, and times each round from fork() to wait().  Every round
+   needs the frames that the one before it gave back, so with a
+   user pool of about 128 MB and no swap disk a leaked or slowly
+   released frame table shows up as a failed child or a time that
+   grows from round to round.  Times are in TSC cycles. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define MB (1024 * 1024)
+#define PAGE_SIZE 4096
+#define REGION_SIZE (64 * MB)
+#define ROUND_CNT 8
+
+static char region[REGION_SIZE];
+
+/* Fills every page of REGION, then checks that each still holds
+   what was written.  Returns 0 on success. */
+static int
+fill (void)
+{
+  size_t ofs;
+
+  for (ofs = 0; ofs < REGION_SIZE; ofs += PAGE_SIZE)
+    region[ofs] = (char) (ofs / PAGE_SIZE);
+  for (ofs = 0; ofs < REGION_SIZE; ofs += PAGE_SIZE)
+    if (region[ofs] != (char) (ofs / PAGE_SIZE))
+      return 1;
+  return 0;
+}
+
+void
+test_main (void)
+{
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++)
+    {
+      uint64_t start, cycles;
+      pid_t child;
+
+      start = rdtsc ();
+      child = fork ("child");
+      if (child == 0)
+        exit (fill ());
+      CHECK (child > 0, "fork child %d", i);
+      CHECK (wait (child) == 0, "child %d filled 64 MB", i);
+      cycles = rdtsc () - start;
+      msg ("rate: round %d took %llu cycles", i, cycles);
+    }
+}
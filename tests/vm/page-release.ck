@@ -0,0 +1,32 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+compare_output ("run", IGNORE_RATES => 1, IGNORE_EXIT_CODES => 1,
+		\@output, [<<'EOF']);
+(page-release) begin
+(page-release) fork child 0
+(page-release) child 0 filled 64 MB
+(page-release) fork child 1
+(page-release) child 1 filled 64 MB
+(page-release) fork child 2
+(page-release) child 2 filled 64 MB
+(page-release) fork child 3
+(page-release) child 3 filled 64 MB
+(page-release) fork child 4
+(page-release) child 4 filled 64 MB
+(page-release) fork child 5
+(page-release) child 5 filled 64 MB
+(page-release) fork child 6
+(page-release) child 6 filled 64 MB
+(page-release) fork child 7
+(page-release) child 7 filled 64 MB
+(page-release) end
+EOF
+pass;
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(replace-aging) begin
+(replace-aging) fork child 0
+(replace-aging) fork child 1
+(replace-aging) child 0 kept its pages
+(replace-aging) child 1 kept its pages
+(replace-aging) end
+EOF
+pass;
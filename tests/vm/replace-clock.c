@@ -0,0 +1,10 @@
+/* Runs the page replacement workload under the clock policy. */
+
+#include "tests/main.h"
+#include "tests/vm/replace-workload.h"
+
+void
+test_main (void) 
+{
+  replace_workload ();
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(replace-clock) begin
+(replace-clock) fork child 0
+(replace-clock) fork child 1
+(replace-clock) child 0 kept its pages
+(replace-clock) child 1 kept its pages
+(replace-clock) end
+EOF
+pass;
@@ -0,0 +1,88 @@
+/* Page replacement workload shared by the replace-* tests, which
+   run it under each policy.  Two processes at once each keep
+   rewriting a small hot set while sweeping a much larger cold
+   region, so that together they need about twice as much memory
+   as there is.  A policy that keeps the hot pages resident takes
+   fewer page faults; compare the "VM: N page faults" lines that
+   the kernel prints at shutdown. */
+
+#include "tests/vm/replace-workload.h"
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HOT_PAGES 128                   /* 512 kB, always in use. */
+#define COLD_PAGES 1920                 /* 7.5 MB, swept in slices. */
+#define SLICE_PAGES 64                  /* Cold pages per round. */
+#define HOT_PASSES 4                    /* Hot passes per round. */
+#define ROUND_CNT 90                    /* Three sweeps of the cold pages. */
+#define CHILD_CNT 2
+
+static char hot[HOT_PAGES * PAGE_SIZE];
+static char cold[COLD_PAGES * PAGE_SIZE];
+
+/* Returns the byte that ROUND leaves in page PAGE of BUF. */
+static char
+stamp (const char *buf, size_t page, int round)
+{
+  return (char) ((buf == hot ? 0x55 : 0xaa) ^ page ^ round);
+}
+
+/* Writes ROUND's stamp into every page of BUF from FIRST to
+   FIRST + CNT. */
+static void
+touch (char *buf, size_t first, size_t cnt, int round)
+{
+  size_t page;
+
+  for (page = first; page < first + cnt; page++)
+    buf[page * PAGE_SIZE] = stamp (buf, page, round);
+}
+
+/* Runs the workload in one process.  Returns 0 if every page
+   still holds what was last written to it. */
+static int
+run (void)
+{
+  size_t page;
+  int round, pass;
+
+  for (round = 0; round < ROUND_CNT; round++)
+    {
+      for (pass = 0; pass < HOT_PASSES; pass++)
+        touch (hot, 0, HOT_PAGES, round);
+      touch (cold, round * SLICE_PAGES % COLD_PAGES, SLICE_PAGES, round);
+    }
+
+  for (page = 0; page < HOT_PAGES; page++)
+    if (hot[page * PAGE_SIZE] != stamp (hot, page, ROUND_CNT - 1))
+      return 1;
+  for (page = 0; page < COLD_PAGES; page++)
+    {
+      /* Slice S was last written in round ROUND_CNT - slices + S. */
+      int slices = COLD_PAGES / SLICE_PAGES;
+      int last = ROUND_CNT - slices + (int) (page / SLICE_PAGES);
+
+      if (cold[page * PAGE_SIZE] != stamp (cold, page, last))
+        return 1;
+    }
+  return 0;
+}
+
+void
+replace_workload (void)
+{
+  pid_t children[CHILD_CNT];
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      children[i] = fork ("child");
+      if (children[i] == 0)
+        exit (run ());
+      CHECK (children[i] > 0, "fork child %d", i);
+    }
+  for (i = 0; i < CHILD_CNT; i++)
+    CHECK (wait (children[i]) == 0, "child %d kept its pages", i);
+}
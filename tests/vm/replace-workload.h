@@ -0,0 +1,6 @@
+#ifndef TESTS_VM_REPLACE_WORKLOAD
+#define TESTS_VM_REPLACE_WORKLOAD 1
+
+void replace_workload (void);
+
+#endif /* tests/vm/replace-workload.h */
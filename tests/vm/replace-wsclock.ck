@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(replace-wsclock) begin
+(replace-wsclock) fork child 0
+(replace-wsclock) fork child 1
+(replace-wsclock) child 0 kept its pages
+(replace-wsclock) child 1 kept its pages
+(replace-wsclock) end
+EOF
+pass;
@@ -0,0 +1,31 @@
+/* Writes 12 MB of anonymous memory with only 10 MB of RAM, then
+   checks it.  The free user frames run out partway through, which
+   should wake the background reclaimer; the .ck file checks the
+   reclaim statistics that the kernel prints at shutdown to see
+   that it ran. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (12 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunks[i * PAGE_SIZE] = (char) i;
+  msg ("wrote %d pages", PAGE_COUNT);
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunks[i * PAGE_SIZE] != (char) i)
+      fail ("page %zu is inconsistent", i);
+  msg ("read back %d pages", PAGE_COUNT);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(swap-reclaim) begin
+(swap-reclaim) wrote 3072 pages
+(swap-reclaim) read back 3072 pages
+(swap-reclaim) end
+EOF
+
+my ($stats) = grep (/^Reclaim:/, @output);
+fail "missing reclaim statistics\n" if !defined $stats;
+my ($background) = $stats =~ /(\d+) frames in background/;
+fail "reclaimer never evicted a frame\n" if !$background;
+pass;
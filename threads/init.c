@@ -16,10 +16,12 @@
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
+#include "threads/lockstat.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -31,6 +33,7 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/replace.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -220,15 +223,31 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-cfs"))
+			thread_cfs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+#ifdef LOCKSTAT
+		else if (!strcmp (name, "-lockstat"))
+			lockstat_top = atoi (value);
+#endif
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-vm-replace")) {
+			if (value == NULL || !replace_policy_set (value))
+				PANIC ("unknown page replacement policy `%s'", value);
+		}
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
 	}
+	if (thread_mlfqs && thread_cfs)
+		PANIC ("-mlfqs and -cfs cannot be used together");
 
 	return argv;
 }
@@ -325,8 +344,17 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Use the weighted fair-share scheduler.\n"
+			"  -tickless          Stop the timer tick while idle.\n"
+#ifdef LOCKSTAT
+			"  -lockstat=N        Print the N most contended locks at shutdown.\n"
+#endif
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -vm-replace=POLICY Evict pages by POLICY: clock, wsclock (default)\n"
+			"                     or aging.\n"
 #endif
 			);
 	power_off ();
@@ -353,6 +381,11 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	palloc_print_stats ();
+	kmem_cache_print_stats ();
+#ifdef LOCKSTAT
+	lockstat_print_stats ();
+#endif
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -361,4 +394,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "threads/lockstat.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+
+#ifdef LOCKSTAT
+
+/* Statistics for each lock name seen so far.  Names are few and
+   fixed, so a small table searched linearly when a lock is named
+   is enough, and it needs no allocator. */
+#define LOCKSTAT_MAX 32
+static struct lockstat stats[LOCKSTAT_MAX];
+static int stat_cnt;
+
+int lockstat_top;
+
+/* Returns the statistics entry for locks named NAME, creating it
+   if this is the first lock with that name, or a null pointer if
+   the table is full. */
+struct lockstat *
+lockstat_lookup (const char *name) {
+	struct lockstat *s = NULL;
+	enum intr_level old_level;
+	int i;
+
+	ASSERT (name != NULL);
+
+	old_level = intr_disable ();
+	for (i = 0; i < stat_cnt; i++)
+		if (!strcmp (stats[i].name, name)) {
+			s = &stats[i];
+			break;
+		}
+	if (s == NULL && stat_cnt < LOCKSTAT_MAX) {
+		s = &stats[stat_cnt++];
+		s->name = name;
+	}
+	intr_set_level (old_level);
+	return s;
+}
+
+/* Records an acquisition of a lock counted in S, which took WAIT
+   cycles and had to wait for another holder if CONTENDED. */
+void
+lockstat_acquired (struct lockstat *s, bool contended, uint64_t wait) {
+	enum intr_level old_level = intr_disable ();
+
+	s->acquired++;
+	if (contended) {
+		s->contended++;
+		s->wait_cycles += wait;
+		if (wait > s->max_wait)
+			s->max_wait = wait;
+	}
+	intr_set_level (old_level);
+}
+
+/* Records the release of a lock counted in S after HOLD cycles. */
+void
+lockstat_released (struct lockstat *s, uint64_t hold) {
+	enum intr_level old_level = intr_disable ();
+
+	s->hold_cycles += hold;
+	if (hold > s->max_hold)
+		s->max_hold = hold;
+	intr_set_level (old_level);
+}
+
+/* Prints the lockstat_top locks with the most total wait time. */
+void
+lockstat_print_stats (void) {
+	bool printed[LOCKSTAT_MAX];
+	int i, n;
+
+	if (lockstat_top <= 0)
+		return;
+
+	printf ("Lockstat: top %d of %d locks by wait time, in TSC cycles\n",
+			lockstat_top < stat_cnt ? lockstat_top : stat_cnt, stat_cnt);
+	printf ("%-16s %10s %10s %14s %12s %14s %12s\n", "name", "acquired",
+			"contended", "wait", "max wait", "hold", "max hold");
+
+	memset (printed, 0, sizeof printed);
+	for (n = 0; n < lockstat_top && n < stat_cnt; n++) {
+		struct lockstat *s = NULL;
+
+		for (i = 0; i < stat_cnt; i++)
+			if (!printed[i] && (s == NULL || stats[i].wait_cycles > s->wait_cycles))
+				s = &stats[i];
+		printed[s - stats] = true;
+		printf ("%-16s %10"PRIu64" %10"PRIu64" %14"PRIu64" %12"PRIu64
+				" %14"PRIu64" %12"PRIu64"\n", s->name, s->acquired,
+				s->contended, s->wait_cycles, s->max_wait, s->hold_cycles,
+				s->max_hold);
+	}
+}
+
+#endif /* LOCKSTAT */
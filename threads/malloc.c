@@ -7,9 +7,32 @@
 #include <string.h>
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
-/* A simple implementation of malloc(). */
+/* A simple implementation of malloc().
+
+   Requests up to about half a page are served from size classes.
+   Each class carves single-page "arenas" into equal blocks, so a
+   block's arena is always found by rounding its address down to a
+   page.  The classes are spaced about 1.25x apart, and each class
+   is then stretched to the largest multiple of 16 bytes that still
+   fits the same number of blocks per page, so that little of an
+   arena is left over.  This ends with classes that fit three and
+   two blocks per page, which give medium objects such as inodes a
+   third or half of a page instead of a whole one.
+
+   Larger requests get their own run of pages with an arena header
+   at the start ("big blocks").
+
+   Each thread keeps a "magazine" of free blocks per class, after
+   Bonwick and Adams.  malloc() and free() of a class block only
+   pop from or push onto the running thread's magazine, which no
+   other thread touches, so they take no lock.  An empty magazine
+   is refilled, and an overfull one drained, half a magazine at a
+   time under a single acquisition of the descriptor's lock.
+   Blocks in magazines still count as allocated in their arenas;
+   a thread gives its magazines back when it exits. */
 
 /* Descriptor. */
 struct desc {
@@ -17,8 +40,12 @@ struct desc {
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
 	struct lock lock;           /* Lock. */
+	size_t mag_size;            /* Blocks a magazine holds. */
 };
 
+/* Most blocks a magazine holds. */
+#define MAG_MAX 16
+
 /* Magic number for detecting arena corruption. */
 #define ARENA_MAGIC 0x9a548eed
 
@@ -31,28 +58,76 @@ struct arena {
 
 /* Free block. */
 struct block {
-	struct list_elem free_elem; /* Free list element. */
+	union {
+		struct list_elem free_elem; /* Free list element. */
+		struct block *next;         /* Next block in a magazine. */
+	};
+};
+
+/* A thread's cache of free blocks of one descriptor. */
+struct magazine {
+	struct block *top;          /* Most recently freed block. */
+	size_t cnt;                 /* Number of blocks. */
 };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[32];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Granularity of size classes, in bytes. */
+#define CLASS_ALIGN 16
+
+/* Maps a request size, in units of CLASS_ALIGN, to the smallest
+   descriptor that can satisfy it. */
+static uint8_t class_of[PGSIZE / 2 / CLASS_ALIGN + 1];
+static size_t max_class_size;   /* Largest size served by a class. */
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct magazine *thread_magazine (struct desc *);
+static size_t desc_refill (struct desc *, struct magazine *, size_t cnt);
+static void desc_drain (struct desc *, struct magazine *, size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
-	size_t block_size;
+	const size_t space = PGSIZE - sizeof (struct arena);
+	size_t size, i;
+
+	for (size = CLASS_ALIGN; ; ) {
+		size_t blocks = space / size;
+		struct desc *d;
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
+		/* A block per page is better served as a big block. */
+		if (blocks < 2)
+			break;
+
+		/* Stretch SIZE as far as it goes with the same number of
+		   blocks per arena. */
+		size = ROUND_DOWN (space / blocks, CLASS_ALIGN);
+
+		d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
-		d->block_size = block_size;
-		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+		d->block_size = size;
+		d->blocks_per_arena = blocks;
+		d->mag_size = blocks / 2 < MAG_MAX ? blocks / 2 : MAG_MAX;
 		list_init (&d->free_list);
 		lock_init (&d->lock);
+		lock_set_name (&d->lock, "malloc");
+
+		/* Space the next class about 1.25x further up, but at
+		   least CLASS_ALIGN. */
+		size = ROUND_UP (size + size / 4, CLASS_ALIGN);
+		if (size < d->block_size + CLASS_ALIGN)
+			size = d->block_size + CLASS_ALIGN;
+	}
+
+	max_class_size = descs[desc_cnt - 1].block_size;
+	ASSERT (max_class_size / CLASS_ALIGN < sizeof class_of);
+	for (i = 0, size = 0; size <= max_class_size; size += CLASS_ALIGN) {
+		while (descs[i].block_size < size)
+			i++;
+		class_of[size / CLASS_ALIGN] = i;
 	}
 }
 
@@ -61,6 +136,7 @@ malloc_init (void) {
 void *
 malloc (size_t size) {
 	struct desc *d;
+	struct magazine *m;
 	struct block *b;
 	struct arena *a;
 
@@ -70,10 +146,7 @@ malloc (size_t size) {
 
 	/* Find the smallest descriptor that satisfies a SIZE-byte
 	   request. */
-	for (d = descs; d < descs + desc_cnt; d++)
-		if (d->block_size >= size)
-			break;
-	if (d == descs + desc_cnt) {
+	if (size > max_class_size) {
 		/* SIZE is too big for any descriptor.
 		   Allocate enough pages to hold SIZE plus an arena. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
@@ -88,35 +161,18 @@ malloc (size_t size) {
 		a->free_cnt = page_cnt;
 		return a + 1;
 	}
+	d = &descs[class_of[DIV_ROUND_UP (size, CLASS_ALIGN)]];
 
-	lock_acquire (&d->lock);
-
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
-
-		/* Allocate a page. */
-		a = palloc_get_page (0);
-		if (a == NULL) {
-			lock_release (&d->lock);
-			return NULL;
-		}
-
-		/* Initialize arena and add its blocks to the free list. */
-		a->magic = ARENA_MAGIC;
-		a->desc = d;
-		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
-	}
-
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
-	lock_release (&d->lock);
+	/* Take a block from this thread's magazine, refilling it from
+	   the descriptor if it is empty. */
+	m = thread_magazine (d);
+	if (m == NULL)
+		return NULL;
+	if (m->cnt == 0 && desc_refill (d, m, (d->mag_size + 1) / 2) == 0)
+		return NULL;
+	b = m->top;
+	m->top = b->next;
+	m->cnt--;
 	return b;
 }
 
@@ -155,12 +211,26 @@ block_size (void *block) {
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
-   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+   OLD_BLOCK stays where it is if NEW_SIZE still fits in it; a
+   big block that shrinks gives its unneeded pages back. */
 void *
 realloc (void *old_block, size_t new_size) {
 	if (new_size == 0) {
 		free (old_block);
 		return NULL;
+	} else if (old_block != NULL && new_size <= block_size (old_block)) {
+		struct arena *a = block_to_arena (old_block);
+
+		if (a->desc == NULL) {
+			size_t page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+			if (page_cnt < a->free_cnt) {
+				palloc_free_multiple ((uint8_t *) a + page_cnt * PGSIZE,
+						a->free_cnt - page_cnt);
+				a->free_cnt = page_cnt;
+			}
+		}
+		return old_block;
 	} else {
 		void *new_block = malloc (new_size);
 		if (old_block != NULL && new_block != NULL) {
@@ -184,30 +254,28 @@ free (void *p) {
 
 		if (d != NULL) {
 			/* It's a normal block.  We handle it here. */
+			struct magazine *m;
 
 #ifndef NDEBUG
 			/* Clear the block to help detect use-after-free bugs. */
 			memset (b, 0xcc, d->block_size);
 #endif
 
-			lock_acquire (&d->lock);
-
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
+			/* Push it onto this thread's magazine, draining half of
+			   the magazine if it overflows.  Without a magazine, hand
+			   the block straight back to the descriptor. */
+			m = thread_magazine (d);
+			if (m == NULL) {
+				struct magazine single = {b, 1};
 
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
-				palloc_free_page (a);
+				b->next = NULL;
+				desc_drain (d, &single, 1);
+				return;
 			}
-
-			lock_release (&d->lock);
+			b->next = m->top;
+			m->top = b;
+			if (++m->cnt > d->mag_size)
+				desc_drain (d, m, m->cnt - d->mag_size / 2);
 		} else {
 			/* It's a big block.  Free its pages. */
 			palloc_free_multiple (a, a->free_cnt);
@@ -216,6 +284,131 @@ free (void *p) {
 	}
 }
 
+/* Gives the blocks in the running thread's magazines back to
+   their descriptors, then frees the magazines.  Called by
+   thread_exit(). */
+void
+malloc_thread_exit (void) {
+	struct thread *t = thread_current ();
+	struct magazine *mags = t->magazines;
+	struct magazine single;
+	size_t i;
+
+	if (mags == NULL)
+		return;
+	for (i = 0; i < desc_cnt; i++)
+		if (mags[i].cnt > 0)
+			desc_drain (&descs[i], &mags[i], mags[i].cnt);
+
+	/* The magazines came straight from their descriptor, so they
+	   go straight back to it. */
+	t->magazines = NULL;
+	single.top = (struct block *) mags;
+	single.top->next = NULL;
+	single.cnt = 1;
+	desc_drain (block_to_arena (single.top)->desc, &single, 1);
+}
+
+/* Returns the running thread's magazine for descriptor D, first
+   giving the thread its set of magazines if it has none yet.
+   Returns a null pointer if memory is not available. */
+static struct magazine *
+thread_magazine (struct desc *d) {
+	struct thread *t = thread_current ();
+
+	if (t->magazines == NULL) {
+		size_t size = desc_cnt * sizeof *t->magazines;
+		struct desc *md = &descs[class_of[DIV_ROUND_UP (size, CLASS_ALIGN)]];
+		struct magazine single = {NULL, 0};
+
+		/* Take the magazines themselves straight from their
+		   descriptor, since there are none to go through yet. */
+		if (desc_refill (md, &single, 1) == 0)
+			return NULL;
+		t->magazines = (struct magazine *) single.top;
+		memset (t->magazines, 0, size);
+	}
+	return &t->magazines[d - descs];
+}
+
+/* Moves up to CNT blocks from descriptor D's free list onto
+   magazine M, first creating an arena if D has no free blocks.
+   Returns the number of blocks moved, which is 0 only if memory
+   is not available. */
+static size_t
+desc_refill (struct desc *d, struct magazine *m, size_t cnt) {
+	size_t moved;
+
+	lock_acquire (&d->lock);
+
+	/* If the free list is empty, create a new arena. */
+	if (list_empty (&d->free_list)) {
+		struct arena *a;
+		size_t i;
+
+		/* Allocate a page. */
+		a = palloc_get_page (0);
+		if (a == NULL) {
+			lock_release (&d->lock);
+			return 0;
+		}
+
+		/* Initialize arena and add its blocks to the free list. */
+		a->magic = ARENA_MAGIC;
+		a->desc = d;
+		a->free_cnt = d->blocks_per_arena;
+		for (i = 0; i < d->blocks_per_arena; i++) {
+			struct block *b = arena_to_block (a, i);
+			list_push_back (&d->free_list, &b->free_elem);
+		}
+	}
+
+	/* Move blocks from the free list to the magazine. */
+	for (moved = 0; moved < cnt && !list_empty (&d->free_list); moved++) {
+		struct block *b = list_entry (list_pop_front (&d->free_list),
+				struct block, free_elem);
+		block_to_arena (b)->free_cnt--;
+		b->next = m->top;
+		m->top = b;
+		m->cnt++;
+	}
+
+	lock_release (&d->lock);
+	return moved;
+}
+
+/* Moves CNT blocks from magazine M back to descriptor D's free
+   list, freeing each arena that becomes entirely unused. */
+static void
+desc_drain (struct desc *d, struct magazine *m, size_t cnt) {
+	ASSERT (cnt <= m->cnt);
+
+	lock_acquire (&d->lock);
+	while (cnt-- > 0) {
+		struct block *b = m->top;
+		struct arena *a = block_to_arena (b);
+
+		m->top = b->next;
+		m->cnt--;
+
+		/* Add block to free list. */
+		list_push_front (&d->free_list, &b->free_elem);
+
+		/* If the arena is now entirely unused, free it. */
+		if (++a->free_cnt >= d->blocks_per_arena) {
+			size_t i;
+
+			ASSERT (a->free_cnt == d->blocks_per_arena);
+			for (i = 0; i < d->blocks_per_arena; i++) {
+				struct block *b = arena_to_block (a, i);
+				list_remove (&b->free_elem);
+			}
+			palloc_free_page (a);
+		}
+	}
+	lock_release (&d->lock);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b) {
@@ -289,6 +289,23 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 	}
 }
 
+/* Sets the writable bit to WRITABLE in the PTE for virtual page
+ * VPAGE in PML4, keeping the other bits, in particular the dirty
+ * and accessed bits. */
+void
+pml4_set_writable (uint64_t *pml4, const void *vpage, bool writable) {
+	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	if (pte) {
+		if (writable)
+			*pte |= PTE_W;
+		else
+			*pte &= ~(uint64_t) PTE_W;
+
+		if (rcr3 () == vtop (pml4))
+			invlpg ((uint64_t) vpage);
+	}
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 has been
  * accessed recently, that is, between the time the PTE was
  * installed and the last time it was cleared.  Returns false if
@@ -2,6 +2,7 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -24,13 +25,30 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Its free pages are kept
+   as blocks of 2**K pages, for orders K up to MAX_ORDER, each
+   aligned to its size relative to the pool's base, on one free
+   list per order.  An allocation takes the smallest block that is
+   big enough, splitting off buddies on the way down, and returns
+   the pages it does not need beyond PAGE_CNT.  A freed block is
+   merged with its buddy for as long as the buddy is free too.
+   Both take O(MAX_ORDER) steps.  A free block's list element is
+   stored in its first page, and free_order records which pages
+   head a free block of which order. */
+#define MAX_ORDER 24                    /* Largest block: 2**24 pages. */
 
 /* A memory pool. */
 struct pool {
 	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
 	uint8_t *base;                  /* Base of pool. */
+	uint8_t *free_order;            /* Per page: 1 + order if it heads
+	                                   a free block, otherwise 0. */
+	struct list free_lists[MAX_ORDER + 1]; /* Free blocks by order. */
+	size_t free_cnt[MAX_ORDER + 1]; /* # of blocks in each list. */
+	uint32_t free_mask;             /* Orders with free blocks. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -42,6 +60,10 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static size_t pool_alloc (struct pool *, size_t page_cnt);
+static void pool_free (struct pool *, size_t page_idx, size_t page_cnt);
+static size_t pool_free_pages (const struct pool *);
+static void print_pool_stats (const char *name, struct pool *);
 
 /* multiboot info */
 struct multiboot_info {
@@ -223,12 +245,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_free (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_free (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -264,7 +286,7 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
 
 	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+	size_t page_idx = pool_alloc (pool, page_cnt);
 	lock_release (&pool->lock);
 	void *pages;
 
@@ -318,8 +340,10 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
+	lock_acquire (&pool->lock);
 	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	pool_free (pool, page_idx, page_cnt);
+	lock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -328,18 +352,74 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of free pages in the kernel pool, or in the
+   user pool if PAL_USER is set in FLAGS. */
+size_t
+palloc_free_cnt (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t free_pages;
+
+	lock_acquire (&pool->lock);
+	free_pages = pool_free_pages (pool);
+	lock_release (&pool->lock);
+	return free_pages;
+}
+
+/* Returns the order of the largest free block in the kernel pool,
+   or in the user pool if PAL_USER is set in FLAGS, or -1 if the
+   pool has no free pages. */
+int
+palloc_largest_order (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	int order = -1;
+
+	lock_acquire (&pool->lock);
+	if (pool->free_mask != 0)
+		order = 31 - __builtin_clz (pool->free_mask);
+	lock_release (&pool->lock);
+	return order;
+}
+
+/* Returns the number of pages in the kernel pool, or in the user
+   pool if PAL_USER is set in FLAGS, and stores the address of the
+   pool's first page in *BASE.  Every page the pool hands out lies
+   in that range. */
+size_t
+palloc_pool_range (enum palloc_flags flags, void **base) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+
+	*base = pool->base;
+	return bitmap_size (pool->used_map);
+}
+
+/* Prints the free blocks of each pool by order. */
+void
+palloc_print_stats (void) {
+	print_pool_stats ("kernel", &kernel_pool);
+	print_pool_stats ("user", &user_pool);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
+  /* We'll put the pool's used_map and free_order at its base.
+     Calculate the space needed for them
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t bm_size = ROUND_UP (bitmap_buf_size (pgcnt), sizeof (void *));
+	size_t bm_pages = DIV_ROUND_UP (bm_size + pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
 	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_size);
 	p->base = (void *) start;
+	p->free_order = (uint8_t *) *bm_base + bm_size;
+	memset (p->free_order, 0, pgcnt);
+	for (order = 0; order <= MAX_ORDER; order++) {
+		list_init (&p->free_lists[order]);
+		p->free_cnt[order] = 0;
+	}
+	p->free_mask = 0;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
@@ -347,6 +427,143 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
 	*bm_base += bm_pages;
 }
 
+/* Returns the free list element kept in page PAGE_IDX of P. */
+static struct list_elem *
+block_elem (const struct pool *p, size_t page_idx) {
+	return (struct list_elem *) (p->base + page_idx * PGSIZE);
+}
+
+/* Adds the block of 2**ORDER pages at PAGE_IDX to P's free
+   lists. */
+static void
+block_push (struct pool *p, size_t page_idx, int order) {
+	p->free_order[page_idx] = order + 1;
+	list_push_front (&p->free_lists[order], block_elem (p, page_idx));
+	p->free_cnt[order]++;
+	p->free_mask |= 1u << order;
+}
+
+/* Removes the free block of 2**ORDER pages at PAGE_IDX from P's
+   free lists. */
+static void
+block_remove (struct pool *p, size_t page_idx, int order) {
+	ASSERT (p->free_order[page_idx] == order + 1);
+
+	p->free_order[page_idx] = 0;
+	list_remove (block_elem (p, page_idx));
+	if (--p->free_cnt[order] == 0)
+		p->free_mask &= ~(1u << order);
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX in P, merging it
+   with its buddy, and the result with its own buddy, for as long
+   as the buddy is a free block of the same order. */
+static void
+block_free (struct pool *p, size_t page_idx, int order) {
+	size_t page_cnt = bitmap_size (p->used_map);
+
+	while (order < MAX_ORDER) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy >= page_cnt || p->free_order[buddy] != order + 1)
+			break;
+		block_remove (p, buddy, order);
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	block_push (p, page_idx, order);
+}
+
+/* Allocates PAGE_CNT contiguous pages from P and returns the
+   index of the first, or BITMAP_ERROR if there is no free block
+   big enough.  P's lock must be held. */
+static size_t
+pool_alloc (struct pool *p, size_t page_cnt) {
+	uint32_t avail;
+	size_t page_idx;
+	int order = 0;
+	int k;
+
+	if (page_cnt == 0)
+		return BITMAP_ERROR;
+	while (((size_t) 1 << order) < page_cnt)
+		if (++order > MAX_ORDER)
+			return BITMAP_ERROR;
+
+	/* Take the smallest free block that is big enough. */
+	avail = p->free_mask & ~((1u << order) - 1);
+	if (avail == 0)
+		return BITMAP_ERROR;
+	k = __builtin_ctz (avail);
+	page_idx = ((uint8_t *) list_front (&p->free_lists[k]) - p->base) / PGSIZE;
+	block_remove (p, page_idx, k);
+
+	/* Split it down to ORDER, freeing the upper halves. */
+	while (k > order) {
+		k--;
+		block_push (p, page_idx + ((size_t) 1 << k), k);
+	}
+
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, true);
+	if (page_cnt < (size_t) 1 << order)
+		pool_free (p, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+	return page_idx;
+}
+
+/* Frees the PAGE_CNT pages starting at PAGE_IDX in P, which need
+   not form a single block: the range is carved into the largest
+   aligned blocks that fit.  P's lock must be held, except while
+   the pools are being populated. */
+static void
+pool_free (struct pool *p, size_t page_idx, size_t page_cnt) {
+	bitmap_set_multiple (p->used_map, page_idx, page_cnt, false);
+	while (page_cnt > 0) {
+		int order = MAX_ORDER;
+
+		if (page_idx != 0 && __builtin_ctzll (page_idx) < order)
+			order = __builtin_ctzll (page_idx);
+		while (((size_t) 1 << order) > page_cnt)
+			order--;
+		block_free (p, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Returns the number of free pages in P, whose lock must be
+   held. */
+static size_t
+pool_free_pages (const struct pool *p) {
+	size_t free_pages = 0;
+	int order;
+
+	for (order = 0; order <= MAX_ORDER; order++)
+		free_pages += p->free_cnt[order] << order;
+	return free_pages;
+}
+
+/* Prints the free pages of pool P, named NAME, the largest block
+   that can be allocated, and the number of free blocks of each
+   order. */
+static void
+print_pool_stats (const char *name, struct pool *p) {
+	int order;
+
+	lock_acquire (&p->lock);
+	printf ("Palloc %s pool: %zu of %zu pages free", name,
+			pool_free_pages (p), bitmap_size (p->used_map));
+	if (p->free_mask != 0)
+		printf (", largest free order %d (%zu pages)\n",
+				31 - __builtin_clz (p->free_mask),
+				(size_t) 1 << (31 - __builtin_clz (p->free_mask)));
+	else
+		printf (", none contiguous\n");
+	for (order = 0; order <= MAX_ORDER; order++)
+		if (p->free_cnt[order] != 0)
+			printf ("  order %2d: %zu\n", order, p->free_cnt[order]);
+	lock_release (&p->lock);
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
@@ -0,0 +1,242 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator in the style of Bonwick's kmem_cache.
+
+   Each cache owns a set of slabs, one page apiece.  A slab starts
+   with a struct slab header and is filled with as many objects as
+   fit after it; its free objects are chained through their first
+   word.  Slabs that have at least one free object are kept on the
+   cache's list, most recently freed into first, so allocation and
+   freeing are both O(1).  A slab whose objects are all free is
+   handed back to the page allocator unless that would leave the
+   cache with less than a slab's worth of free objects, which saves
+   a round trip for caches that hover around a slab boundary. */
+
+/* Cache. */
+struct kmem_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t obj_size;            /* Size of each object in bytes. */
+	size_t objs_per_slab;       /* Number of objects in a slab. */
+	void (*ctor) (void *);      /* Constructor, or null. */
+	struct list slabs;          /* Slabs with free objects. */
+	struct lock lock;           /* Lock. */
+
+	/* Statistics. */
+	size_t free_cnt;            /* Free objects over all slabs. */
+	size_t slab_cnt;            /* Slabs (pages) in use. */
+	size_t in_use;              /* Objects allocated. */
+	size_t peak;                /* Most objects allocated at once. */
+	unsigned long long alloc_cnt; /* Calls to kmem_cache_alloc(). */
+};
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab0bec
+
+/* Slab. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in cache's slab list. */
+	void *free;                 /* First free object. */
+	size_t free_cnt;            /* Number of free objects. */
+};
+
+/* Our set of caches. */
+static struct kmem_cache caches[16];
+static size_t cache_cnt;
+
+static struct slab *slab_create (struct kmem_cache *);
+static struct slab *obj_to_slab (struct kmem_cache *, void *);
+
+/* Creates and returns a cache of SIZE-byte objects called NAME.
+   If CTOR is nonnull, it is called on each object when the slab
+   holding it is created. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, void (*ctor) (void *)) {
+	struct kmem_cache *c;
+
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+
+	c = &caches[cache_cnt++];
+	ASSERT (cache_cnt <= sizeof caches / sizeof *caches);
+
+	/* Free objects link through their first word, so each object
+	   must hold and be aligned for a pointer. */
+	c->name = name;
+	c->obj_size = ROUND_UP (size, sizeof (void *));
+	c->objs_per_slab = (PGSIZE - sizeof (struct slab)) / c->obj_size;
+	ASSERT (c->objs_per_slab > 0);
+	c->ctor = ctor;
+	list_init (&c->slabs);
+	lock_init (&c->lock);
+	lock_set_name (&c->lock, name);
+	c->free_cnt = c->slab_cnt = c->in_use = c->peak = 0;
+	c->alloc_cnt = 0;
+	return c;
+}
+
+/* Obtains and returns an object from cache C.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	lock_acquire (&c->lock);
+
+	/* If no slab has a free object, create one. */
+	if (list_empty (&c->slabs)) {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		list_push_front (&c->slabs, &s->elem);
+	}
+
+	/* Take the first free object of the first slab. */
+	s = list_entry (list_front (&c->slabs), struct slab, elem);
+	obj = s->free;
+	s->free = *(void **) obj;
+	if (--s->free_cnt == 0)
+		list_remove (&s->elem);
+
+	c->free_cnt--;
+	if (++c->in_use > c->peak)
+		c->peak = c->in_use;
+	c->alloc_cnt++;
+	lock_release (&c->lock);
+	return obj;
+}
+
+/* Obtains an object from cache C and zeroes it.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_zalloc (struct kmem_cache *c) {
+	void *obj = kmem_cache_alloc (c);
+	if (obj != NULL)
+		memset (obj, 0, c->obj_size);
+	return obj;
+}
+
+/* Returns OBJ, which must have been obtained from cache C, to C.
+   A null OBJ is ignored. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+
+	if (obj == NULL)
+		return;
+	s = obj_to_slab (c, obj);
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs, unless
+	   it is supposed to stay constructed. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->obj_size);
+#endif
+
+	lock_acquire (&c->lock);
+	*(void **) obj = s->free;
+	s->free = obj;
+	if (s->free_cnt++ == 0)
+		list_push_front (&c->slabs, &s->elem);
+	c->free_cnt++;
+	c->in_use--;
+
+	/* Release the slab if it is empty and another slab's worth of
+	   objects is free elsewhere. */
+	if (s->free_cnt == c->objs_per_slab
+			&& c->free_cnt >= 2 * c->objs_per_slab) {
+		list_remove (&s->elem);
+		c->free_cnt -= c->objs_per_slab;
+		c->slab_cnt--;
+		s->magic = 0;
+		palloc_free_page (s);
+	}
+	lock_release (&c->lock);
+}
+
+/* Returns the number of objects that fit in one of C's slabs. */
+size_t
+kmem_cache_objs_per_slab (const struct kmem_cache *c) {
+	return c->objs_per_slab;
+}
+
+/* Prints statistics for each cache that has been used. */
+void
+kmem_cache_print_stats (void) {
+	size_t i;
+
+	for (i = 0; i < cache_cnt; i++) {
+		struct kmem_cache *c = &caches[i];
+
+		if (c->alloc_cnt == 0)
+			continue;
+		printf ("Slab %s: %zu-byte objects, %zu per page, %zu pages, "
+				"%zu in use (peak %zu), %llu allocations\n",
+				c->name, c->obj_size, c->objs_per_slab, c->slab_cnt,
+				c->in_use, c->peak, c->alloc_cnt);
+	}
+}
+
+/* Allocates a page for a new slab of cache C, threads its objects
+   onto the slab's free list, and runs C's constructor on each.
+   C's lock must be held.  Returns the new slab, or a null pointer
+   if no page is available. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s;
+	uint8_t *obj;
+	size_t i;
+
+	s = palloc_get_page (0);
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->free = NULL;
+	s->free_cnt = c->objs_per_slab;
+
+	/* Thread the objects from last to first so that they are
+	   handed out in address order. */
+	obj = (uint8_t *) (s + 1) + c->objs_per_slab * c->obj_size;
+	for (i = 0; i < c->objs_per_slab; i++) {
+		obj -= c->obj_size;
+		if (c->ctor != NULL)
+			c->ctor (obj);
+		*(void **) obj = s->free;
+		s->free = obj;
+	}
+
+	c->free_cnt += c->objs_per_slab;
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns the slab of cache C that OBJ is inside. */
+static struct slab *
+obj_to_slab (struct kmem_cache *c, void *obj) {
+	struct slab *s = pg_round_down (obj);
+
+	/* Check that the slab is valid and belongs to C. */
+	ASSERT (s != NULL);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+
+	/* Check that the object is properly aligned for the slab. */
+	ASSERT ((pg_ofs (obj) - sizeof *s) % c->obj_size == 0);
+
+	return s;
+}
@@ -31,7 +31,29 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef LOCKSTAT
+#include "threads/lockstat.h"
+#include "intrinsic.h"
+#endif
 
+/* One semaphore in a condition variable's waiters. */
+struct semaphore_elem {
+	struct heap_elem elem;              /* Heap element. */
+	struct semaphore semaphore;         /* This semaphore. */
+	struct thread *thread;              /* Thread waiting on it. */
+	uint64_t seq;                       /* Arrival order. */
+};
+
+/* Waiters on semaphores and condition variables are kept in
+   pairing heaps ordered by priority, highest first, and among
+   equal priorities by arrival, so that up and signal are
+   O(lg n) and still FIFO within a priority.  When a waiter's
+   priority changes through donation, synch_change_priority()
+   moves it to its new place. */
+static uint64_t next_wait_seq;
+
+static heap_less_func sema_waiter_less;
+static heap_less_func cond_waiter_less;
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -47,7 +69,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	heap_init (&sema->waiters, sema_waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -67,7 +89,11 @@ sema_down (struct semaphore *sema) {
 
 	old_level = intr_disable ();
 	while (sema->value == 0) {
-		list_insert_ordered(&sema->waiters, &thread_current ()->elem, &cmp_priority, NULL);
+		struct thread *curr = thread_current ();
+
+		curr->wait_sema = sema;
+		curr->wait_seq = next_wait_seq++;
+		heap_push (&sema->waiters, &curr->wait_elem);
 		thread_block ();
 	}
 	sema->value--;
@@ -109,12 +135,14 @@ sema_up (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters))
-		{
-			list_sort(&sema->waiters, &cmp_priority, NULL);
-			thread_unblock (list_entry (list_pop_front (&sema->waiters), struct thread, elem));
-		}
-    sema->value++;
+	if (!heap_empty (&sema->waiters)) {
+		struct thread *t = heap_entry (heap_pop (&sema->waiters),
+				struct thread, wait_elem);
+
+		t->wait_sema = NULL;
+		thread_unblock (t);
+	}
+	sema->value++;
 	test_max_priority();
 	intr_set_level (old_level);
 }
@@ -175,6 +203,19 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+#ifdef LOCKSTAT
+	lock->stat = NULL;
+#endif
+}
+
+/* Names LOCK for contention statistics.  Locks that share a NAME
+   are counted together.  Does nothing unless the kernel is built
+   with LOCKSTAT. */
+void
+lock_set_name (struct lock *lock UNUSED, const char *name UNUSED) {
+#ifdef LOCKSTAT
+	lock->stat = lockstat_lookup (name);
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -192,7 +233,11 @@ lock_acquire (struct lock *lock) {
 	ASSERT (!lock_held_by_current_thread (lock));
 	/*-------------------------- project.1-Priority Donation -----------------------------*/
 	struct thread *t = thread_current();
-	if (lock->holder != NULL)
+#ifdef LOCKSTAT
+	bool contended = lock->holder != NULL;
+	uint64_t wait_start = rdtsc ();
+#endif
+	if (lock->holder != NULL && !thread_mlfqs)
 	{
 		t->wait_on_lock = lock;
 		list_push_back(&lock->holder->donations, &t->donation_elem);
@@ -201,6 +246,13 @@ lock_acquire (struct lock *lock) {
 	sema_down (&lock->semaphore);
 	t->wait_on_lock = NULL;
 	lock->holder = t;
+#ifdef LOCKSTAT
+	if (lock->stat != NULL) {
+		lock->acquired_at = rdtsc ();
+		lockstat_acquired (lock->stat, contended,
+				lock->acquired_at - wait_start);
+	}
+#endif
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -217,8 +269,15 @@ lock_try_acquire (struct lock *lock) {
 	ASSERT (!lock_held_by_current_thread (lock));
 
 	success = sema_try_down (&lock->semaphore);
-	if (success)
+	if (success) {
 		lock->holder = thread_current ();
+#ifdef LOCKSTAT
+		if (lock->stat != NULL) {
+			lock->acquired_at = rdtsc ();
+			lockstat_acquired (lock->stat, false, 0);
+		}
+#endif
+	}
 	return success;
 }
 
@@ -233,9 +292,16 @@ lock_release (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
+#ifdef LOCKSTAT
+	if (lock->stat != NULL)
+		lockstat_released (lock->stat, rdtsc () - lock->acquired_at);
+#endif
 	lock->holder = NULL;
-	remove_with_lock(lock);
-	refresh_priority();
+	if (!thread_mlfqs)
+	{
+		remove_with_lock(lock);
+		refresh_priority();
+	}
 	sema_up (&lock->semaphore);
 }
 
@@ -249,11 +315,133 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
-struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
-	struct semaphore semaphore;         /* This semaphore. */
-};
+/* Initializes RW as an unheld reader-writer lock.
+
+   Readers and writers both queue on RW->writer, so they are
+   admitted in priority order and a thread that waits behind the
+   writer donates its priority to it, exactly as with a lock.  A
+   reader takes RW->writer only long enough to count itself in;
+   a writer keeps it for as long as it holds RW and, once it has
+   it, waits on RW->drained for the readers already inside to
+   leave. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->writer);
+	sema_init (&rw->drained, 0);
+	rw->readers = 0;
+	rw->draining = false;
+}
+
+/* Names RW for contention statistics, like lock_set_name().
+   Readers show up as very short holds, since they let go of
+   RW->writer as soon as they are in; only writers hold it for
+   as long as they are inside. */
+void
+rwlock_set_name (struct rwlock *rw, const char *name) {
+	lock_set_name (&rw->writer, name);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (t->read_lock_cnt < RWLOCK_READ_MAX);
+
+	lock_acquire (&rw->writer);
+	old_level = intr_disable ();
+	rw->readers++;
+	intr_set_level (old_level);
+	lock_release (&rw->writer);
+	t->read_locks[t->read_lock_cnt++] = rw;
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level;
+	int i;
+
+	ASSERT (rw != NULL);
+
+	/* Holds are usually released in reverse order. */
+	for (i = t->read_lock_cnt - 1; i >= 0; i--)
+		if (t->read_locks[i] == rw)
+			break;
+	ASSERT (i >= 0);
+	t->read_locks[i] = t->read_locks[--t->read_lock_cnt];
+
+	old_level = intr_disable ();
+	ASSERT (rw->readers > 0);
+	if (--rw->readers == 0 && rw->draining)
+		sema_up (&rw->drained);
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+
+	lock_acquire (&rw->writer);
+	old_level = intr_disable ();
+	if (rw->readers > 0) {
+		rw->draining = true;
+		sema_down (&rw->drained);
+		rw->draining = false;
+	}
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+	ASSERT (rw->readers == 0);
+
+	lock_release (&rw->writer);
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->writer);
+}
+
+/* Returns true if the current thread holds RW for reading, false
+   otherwise. */
+bool
+rwlock_read_by_current_thread (const struct rwlock *rw) {
+	struct thread *t = thread_current ();
+	int i;
+
+	ASSERT (rw != NULL);
+
+	for (i = 0; i < t->read_lock_cnt; i++)
+		if (t->read_locks[i] == rw)
+			return true;
+	return false;
+}
 
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
@@ -262,7 +450,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	heap_init (&cond->waiters, cond_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -288,6 +476,8 @@ cond_init (struct condition *cond) {
 void
 cond_wait (struct condition *cond, struct lock *lock) {
 	struct semaphore_elem waiter;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
@@ -295,7 +485,13 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	ASSERT (lock_held_by_current_thread (lock));
 
 	sema_init (&waiter.semaphore, 0);
-	list_insert_ordered(&cond->waiters, &waiter.elem, &cmp_sem_priority, NULL);
+	waiter.thread = curr;
+	old_level = intr_disable ();
+	waiter.seq = next_wait_seq++;
+	heap_push (&cond->waiters, &waiter.elem);
+	curr->wait_cond = cond;
+	curr->cond_elem = &waiter.elem;
+	intr_set_level (old_level);
 
 	lock_release (lock);
 	sema_down (&waiter.semaphore);
@@ -316,10 +512,16 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters))
-	{
-		list_sort(&cond->waiters, &cmp_sem_priority, NULL);
-		sema_up (&list_entry (list_pop_front (&cond->waiters), struct semaphore_elem, elem)->semaphore);
+	if (!heap_empty (&cond->waiters)) {
+		struct semaphore_elem *waiter;
+		enum intr_level old_level = intr_disable ();
+
+		waiter = heap_entry (heap_pop (&cond->waiters),
+				struct semaphore_elem, elem);
+		waiter->thread->wait_cond = NULL;
+		waiter->thread->cond_elem = NULL;
+		intr_set_level (old_level);
+		sema_up (&waiter->semaphore);
 	}
 }
 
@@ -334,19 +536,53 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!heap_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
 
-bool cmp_sem_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
-{
-	struct semaphore_elem *sa = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sb = list_entry(b, struct semaphore_elem, elem);
-	struct list_elem *sa_e = list_begin(&(sa->semaphore.waiters));
-	struct list_elem *sb_e = list_begin(&(sb->semaphore.waiters));
+/* Sets the priority of T to PRIORITY.  If T is blocked on a
+   semaphore or waiting on a condition variable, also moves it to
+   its new place among that object's waiters.  Callers that change
+   a thread's priority outside the run queue should go through
+   here rather than assign it directly. */
+void
+synch_change_priority (struct thread *t, int priority) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->wait_sema != NULL)
+		heap_remove (&t->wait_sema->waiters, &t->wait_elem);
+	if (t->wait_cond != NULL)
+		heap_remove (&t->wait_cond->waiters, t->cond_elem);
+	t->priority = priority;
+	if (t->wait_sema != NULL)
+		heap_push (&t->wait_sema->waiters, &t->wait_elem);
+	if (t->wait_cond != NULL)
+		heap_push (&t->wait_cond->waiters, t->cond_elem);
+	intr_set_level (old_level);
+}
 
-	struct thread *sa_t = list_entry(sa_e, struct thread, elem);
-	struct thread *sb_t = list_entry(sb_e, struct thread, elem);
+/* Orders threads blocked on a semaphore by descending priority,
+   then by arrival. */
+static bool
+sema_waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct thread *a = heap_entry (a_, struct thread, wait_elem);
+	const struct thread *b = heap_entry (b_, struct thread, wait_elem);
+
+	if (a->priority != b->priority)
+		return a->priority > b->priority;
+	return a->wait_seq < b->wait_seq;
+}
 
-	return (sa_t->priority) > (sb_t->priority);
+/* Orders a condition variable's waiters by their threads'
+   descending priority, then by arrival. */
+static bool
+cond_waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct semaphore_elem *a = heap_entry (a_, struct semaphore_elem, elem);
+	const struct semaphore_elem *b = heap_entry (b_, struct semaphore_elem, elem);
+
+	if (a->thread->priority != b->thread->priority)
+		return a->thread->priority > b->thread->priority;
+	return a->seq < b->seq;
 }
@@ -5,10 +5,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include "devices/timer.h"
+#include "threads/fixed-point.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
@@ -25,17 +29,46 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Scheduler state.
 
-/* THREAD_BLOCKED 상태의 스레드를 관리하기 위한 리스트 자료구조 추가*/
-static struct list sleep_list;
-/* sleep_list에서 대기중인 스레드들의 wakeup_tick값 중 최소값을 저장*/
+   The run queue holds processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO list per priority level, and bit P of `mask'
+   is set iff queues[P] is non-empty, so that enqueue, dequeue and
+   finding the highest ready priority are all constant time.
+
+   Real-time threads (SCHED_FIFO and SCHED_RR) have a second set
+   of priority lists, `rt_queues', that is always served first.
+
+   The run queue is only changed with interrupts off. */
+#if PRI_MAX - PRI_MIN >= 64
+#error run queue mask requires at most 64 priority levels
+#endif
+struct runqueue
+{
+	struct list queues[PRI_MAX - PRI_MIN + 1]; /* READY threads by priority. */
+	uint64_t mask;                          /* Non-empty queues. */
+	struct list rt_queues[PRI_MAX - PRI_MIN + 1]; /* READY real-time threads. */
+	uint64_t rt_mask;                       /* Non-empty rt_queues. */
+	int cnt;                                /* # of threads in all queues. */
+	struct thread *idle;                    /* Idle thread. */
+	unsigned slice_ticks;                   /* # of timer ticks since last yield. */
+	struct rbtree tree;                     /* READY threads by vruntime (cfs). */
+	int64_t min_vruntime;                   /* Floor for vruntime (cfs). */
+};
+static struct runqueue runqueue;
+
+/* Threads blocked in thread_sleep(), kept in a min-heap ordered
+   by wakeup_tick so that arming a sleep is O(1) and expiring the
+   earliest sleeper is O(lg n) in the timer interrupt. */
+static struct heap sleep_queue;
+/* sleep_queue에서 대기중인 스레드들의 wakeup_tick값 중 최소값을 저장*/
 static int64_t next_tick_to_awake;
 
-/* Idle thread. */
-static struct thread *idle_thread;
+/* List of all threads that have not exited yet, for the
+   statistics dump.  Threads are added when they are first
+   initialized and removed when they exit. */
+static struct list all_list;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
@@ -43,9 +76,29 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
+/* Offset of `stack' member within `struct thread'.
+   Used by switch.S, which can't figure it out on its own. */
+uint64_t thread_stack_ofs = offsetof(struct thread, stack);
+
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* Pages of dead threads kept for reuse by thread_create(), which
+   saves a trip through the page allocator and the zeroing of a
+   whole page for each new thread; init_thread() only clears the
+   struct thread part.  The cache never holds more than
+   THREAD_CACHE_MAX pages.  Pages are cached from the scheduler,
+   which cannot sleep on the pool lock, so the least recently
+   cached page that no longer fits moves to thread_free_list
+   instead, and the next thread_create() or thread_exit() gives it
+   back to palloc. */
+#define THREAD_CACHE_MAX 32
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+static struct list thread_free_list;
+
+bool thread_cache_enabled = true;
+
 /* Statistics. */
 static long long idle_ticks;   /* # of timer ticks spent idle. */
 static long long kernel_ticks; /* # of timer ticks in kernel threads. */
@@ -53,11 +106,82 @@ static long long user_ticks;   /* # of timer ticks in user programs. */
 
 /* Scheduling. */
 #define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
+#define RR_TIME_SLICE 10	  /* # of timer ticks for a SCHED_RR thread. */
+
+/* Time slice of each scheduling policy, in timer ticks, or 0 for
+   none. */
+static const unsigned policy_slice[] = {
+	[SCHED_OTHER] = TIME_SLICE,
+	[SCHED_FIFO] = 0,
+	[SCHED_RR] = RR_TIME_SLICE,
+};
+
+/* Dispatch latency of real-time threads: the time from
+   thread_unblock() to the thread running, in a histogram of
+   power-of-two buckets of nanoseconds.  Bucket B counts latencies
+   in [2**B, 2**(B+1)) ns, except that bucket 0 also holds 0. */
+#define RT_LATENCY_BUCKETS 40
+static long long rt_latency_hist[RT_LATENCY_BUCKETS];
+static long long rt_latency_cnt;  /* # of samples. */
+static int64_t rt_latency_max;    /* Worst case, in ns. */
+
+/* Context switches and run-queue waits summed over all threads,
+   including those that have exited. */
+static struct sched_stats sched_totals;
 
 
 bool thread_mlfqs;
 
+/* 4.4BSD scheduler.
+
+   Once a second every thread's recent_cpu decays by a factor that
+   depends on the load average at that moment.  Rather than walk
+   every thread in the timer interrupt, the factor for each second
+   ("epoch") is recorded in decay_history and a thread replays the
+   factors it missed when it is next looked at: when it runs, when
+   it is unblocked, or when its priority is needed.  Only READY
+   threads are revisited each second, since their priorities decide
+   the next thread to run; blocked threads catch up on wakeup. */
+#define NICE_MIN -20			/* Lowest niceness. */
+#define NICE_MAX 20				/* Highest niceness. */
+#define DECAY_HISTORY 64		/* Seconds of decay factors kept. */
+static int load_avg;			/* System load average, fixed point. */
+static int64_t load_epoch;		/* Seconds since boot. */
+static int decay_history[DECAY_HISTORY]; /* Decay factor per epoch. */
+
+bool thread_cfs;
+
+/* Weighted fair-share scheduler, after Linux's CFS.
+
+   Each thread accumulates virtual runtime: every tick it runs
+   adds CFS_TICK_NS scaled by CFS_NICE_0_WEIGHT / weight, so a
+   heavier thread's clock runs slower.  Ready threads sit in a
+   red-black tree ordered by vruntime and the leftmost one runs
+   next; the running thread is preempted once it is more than
+   CFS_GRANULARITY ahead of it.  Over time every thread gets CPU
+   time in proportion to its weight.
+
+   A thread's weight comes from its nice value minus its priority
+   above PRI_DEFAULT, looked up in the same table Linux uses, so
+   each step is worth about 10% of the CPU.  A thread that wakes
+   up is placed no further back than CFS_SLEEP_CREDIT behind the
+   run queue's min_vruntime, so that sleeping does not bank CPU
+   time. */
+#define CFS_TICK_NS (1000000000 / TIMER_FREQ)	/* Tick length. */
+#define CFS_NICE_0_WEIGHT 1024			/* Weight of nice 0. */
+#define CFS_GRANULARITY CFS_TICK_NS		/* Lead that preempts. */
+#define CFS_SLEEP_CREDIT (CFS_TICK_NS * TIME_SLICE / 2)
+static const int cfs_weights[40] = {
+	/* -20 */ 88761, 71755, 56483, 46273, 36291,
+	/* -15 */ 29154, 23254, 18705, 14949, 11916,
+	/* -10 */ 9548, 7620, 6100, 4904, 3906,
+	/*  -5 */ 3121, 2501, 1991, 1586, 1277,
+	/*   0 */ 1024, 820, 655, 526, 423,
+	/*   5 */ 335, 272, 215, 172, 137,
+	/*  10 */ 110, 87, 70, 56, 45,
+	/*  15 */ 36, 29, 23, 18, 15,
+};
+
 static void kernel_thread(thread_func *, void *aux);
 
 static void idle(void *aux UNUSED);
@@ -66,12 +190,32 @@ static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
+static struct thread *thread_page_get(void);
+static void thread_cache_trim(void);
+static bool is_idle(struct thread *);
+static void ready_queue_push(struct thread *);
+static struct thread *ready_queue_pop(struct runqueue *);
+static void ready_queue_remove(struct thread *);
+static int ready_queue_max_priority(uint64_t mask);
+static bool ready_queue_preempts(struct runqueue *, struct thread *);
+static bool is_rt(struct thread *);
+static void rt_latency_record(int64_t ns);
+static void sched_account(struct thread *curr, struct thread *next);
+static void print_sched_stats(const char *name, const struct sched_stats *);
+static int cfs_weight(struct thread *);
+static void cfs_update_min(struct runqueue *, struct thread *curr);
+static bool vruntime_less(const struct rb_node *, const struct rb_node *,
+						  void *aux);
+static void thread_change_priority(struct thread *, int priority);
+static void mlfqs_catch_up(struct thread *);
+static int mlfqs_priority(struct thread *);
+static void mlfqs_second(void);
 void thread_sleep(int64_t);
 void thread_awake(int64_t);
 int64_t get_next_tick_to_awake(void);
 void update_next_tick_to_awake(int64_t);
-bool find_less(struct list_elem *, struct list_elem *, void *);
-void list_check_for_awake(struct list *, int64_t);
+static bool wakeup_less(const struct heap_elem *, const struct heap_elem *,
+						void *aux);
 
 /* 현재 수행중인 스레드와 가장 높은 우선순위의 스레드의 우선순위를 비교하여 스케줄링 */
 void test_max_priority(void);
@@ -121,11 +265,24 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init(&tid_lock);
-	list_init(&ready_list);
-	
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+	{
+		list_init(&runqueue.queues[pri - PRI_MIN]);
+		list_init(&runqueue.rt_queues[pri - PRI_MIN]);
+	}
+	runqueue.mask = 0;
+	runqueue.rt_mask = 0;
+	runqueue.cnt = 0;
+	rbtree_init(&runqueue.tree, vruntime_less, NULL);
+	runqueue.min_vruntime = 0;
+
 	list_init(&destruction_req);
-	/* sleep_list 초기화 */
-	list_init(&sleep_list);
+	list_init(&thread_cache);
+	list_init(&thread_free_list);
+	list_init(&all_list);
+	/* sleep_queue 초기화 */
+	heap_init(&sleep_queue, wakeup_less, NULL);
+	next_tick_to_awake = INT64_MAX;
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread();
 	init_thread(initial_thread, "main", PRI_DEFAULT);
@@ -145,7 +302,7 @@ void thread_start(void)
 	/* Start preemptive thread scheduling. */
 	intr_enable();
 
-	/* Wait for the idle thread to initialize idle_thread. */
+	/* Wait for the idle thread to register itself. */
 	sema_down(&idle_started);
 }
 
@@ -156,7 +313,7 @@ void thread_tick(void)
 	struct thread *t = thread_current();
 
 	/* Update statistics. */
-	if (t == idle_thread)
+	if (is_idle(t))
 		idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
@@ -165,16 +322,98 @@ void thread_tick(void)
 	else
 		kernel_ticks++;
 
+	if (thread_mlfqs)
+	{
+		int64_t now = timer_ticks();
+
+		/* Real-time threads are not scheduled by recent_cpu, so
+		   their CPU time is not charged to it. */
+		if (!is_idle(t) && !is_rt(t))
+		{
+			mlfqs_catch_up(t);
+			t->recent_cpu = fp_add_int(t->recent_cpu, 1);
+		}
+		if (now % TIMER_FREQ == 0)
+			mlfqs_second();
+		if (now % 4 == 0 && !is_idle(t) && !is_rt(t))
+			synch_change_priority(t, mlfqs_priority(t));
+	}
+
+	if (thread_cfs && !is_idle(t) && !is_rt(t))
+	{
+		struct runqueue *rq = &runqueue;
+
+		t->vruntime += (int64_t)CFS_TICK_NS * CFS_NICE_0_WEIGHT / cfs_weight(t);
+		cfs_update_min(rq, t);
+		if (ready_queue_preempts(rq, t))
+			intr_yield_on_return();
+	}
+
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	if (policy_slice[t->policy] != 0
+		&& ++runqueue.slice_ticks >= policy_slice[t->policy])
 		intr_yield_on_return();
 }
 
+/* Charges CNT timer ticks, during which the CPU sat halted in
+   tickless idle without taking a timer interrupt, to the idle
+   thread. */
+void thread_account_idle(int64_t cnt)
+{
+	idle_ticks += cnt;
+}
+
 /* Prints thread statistics. */
 void thread_print_stats(void)
 {
+	struct list_elem *e;
+	int b;
+
 	printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 		   idle_ticks, kernel_ticks, user_ticks);
+
+	print_sched_stats("all threads", &sched_totals);
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, allelem);
+
+		if (!is_idle(t))
+			print_sched_stats(t->name, &t->sched_stats);
+	}
+
+	if (rt_latency_cnt == 0)
+		return;
+	printf("RT dispatch latency: %lld samples, worst %lld ns\n",
+		   rt_latency_cnt, (long long)rt_latency_max);
+	for (b = 0; b < RT_LATENCY_BUCKETS; b++)
+		if (rt_latency_hist[b] != 0)
+			printf("  < %12llu ns: %lld\n", 2ULL << b, rt_latency_hist[b]);
+}
+
+/* Copies the running thread's scheduler statistics into STATS. */
+void thread_get_sched_stats(struct sched_stats *stats)
+{
+	enum intr_level old_level = intr_disable();
+
+	*stats = thread_current()->sched_stats;
+	intr_set_level(old_level);
+}
+
+/* Prints scheduler statistics STATS of NAME: context switches,
+   total run-queue wait and the non-empty histogram buckets. */
+static void
+print_sched_stats(const char *name, const struct sched_stats *stats)
+{
+	int b;
+
+	printf("Sched %s: %llu voluntary, %llu involuntary switches, "
+		   "%lld us ready\n",
+		   name, (unsigned long long)stats->voluntary,
+		   (unsigned long long)stats->involuntary,
+		   (long long)stats->wait_ns / 1000);
+	for (b = 0; b < SCHED_WAIT_BUCKETS; b++)
+		if (stats->wait_hist[b] != 0)
+			printf("  < %8u us: %u\n", 1u << b, stats->wait_hist[b]);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -196,36 +435,64 @@ tid_t thread_create(const char *name, int priority,
 					thread_func *function, void *aux)
 {
 	struct thread *t;
+	struct switch_threads_frame *sf;
 	tid_t tid;
 
 	ASSERT(function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page(PAL_ZERO);
+	thread_cache_trim();
+	t = thread_page_get();
 	if (t == NULL)
 		return TID_ERROR;
 
 	/* Initialize thread. */
 	init_thread(t, name, priority);
 	tid = t->tid = allocate_tid();
+	t->page_refs = 1;		/* Dropped once T has died. */
+	if (thread_mlfqs && function != idle)
+	{
+		/* Inherit the 4.4BSD state of the creating thread. */
+		struct thread *curr = thread_current();
+		enum intr_level old_level = intr_disable();
+
+		mlfqs_catch_up(curr);
+		t->nice = curr->nice;
+		t->recent_cpu = curr->recent_cpu;
+		t->load_epoch = load_epoch;
+		t->priority = t->init_priority = mlfqs_priority(t);
+		intr_set_level(old_level);
+	}
+	if (thread_cfs)
+	{
+		/* Start level with the threads already running. */
+		t->nice = thread_current()->nice;
+		t->vruntime = runqueue.min_vruntime;
+	}
+
+	/* Stack frame for switch_threads(), whose first `ret' into T
+	   lands in switch_entry, which calls kernel_thread(FUNCTION,
+	   AUX).  The frame ends at the top of the page, so once its
+	   `ret' pops RIP, %rsp is 16-byte aligned as that call
+	   requires. */
+	sf = (struct switch_threads_frame *)((uint8_t *)t + PGSIZE) - 1;
+	memset(sf, 0, sizeof *sf);
+	sf->r12 = (uint64_t)function;
+	sf->r13 = (uint64_t)aux;
+	sf->r14 = (uint64_t)kernel_thread;
+	sf->rip = switch_entry;
+	t->stack = (uint8_t *)sf;
 
-	/* Call the kernel_thread if it scheduled.
-	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
-	t->tf.rip = (uintptr_t)kernel_thread;
-	t->tf.R.rdi = (uint64_t)function;
-	t->tf.R.rsi = (uint64_t)aux;
-	t->tf.ds = SEL_KDSEG;
-	t->tf.es = SEL_KDSEG;
-	t->tf.ss = SEL_KDSEG;
-	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
-
-    struct thread *par_t = thread_current();
     t->is_load = false;
     t->is_exit = false;
     sema_init(&t->sema_child_load, 0);
     sema_init(&t->sema_exit, 0);
-    list_push_back(&par_t->my_child, &t->child_elem);
+#ifdef USERPROG
+    /* The parent reaps T through its child list, or lets go of it
+       when the parent exits first. */
+    list_push_back(&thread_current()->my_child, &t->child_elem);
+    t->page_refs++;
+#endif
     t->exit_status = 0;
     t->next_fd = 2;
     t->fd_table[0] = 1;
@@ -233,8 +500,7 @@ tid_t thread_create(const char *name, int priority,
     
 	/* Add to run queue. */
 	thread_unblock(t);
-  if (priority > thread_get_priority())
-        thread_yield();
+	test_max_priority();
 		
 
 	return tid;
@@ -270,7 +536,18 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
-	list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
+	if (thread_mlfqs && !is_idle(t) && !is_rt(t))
+		t->priority = mlfqs_priority(t);
+	t->ready_ns = timer_now_ns();
+	t->woken = true;
+	if (thread_cfs && !is_rt(t))
+	{
+		int64_t floor = runqueue.min_vruntime - CFS_SLEEP_CREDIT;
+
+		if (t->vruntime < floor)
+			t->vruntime = floor;
+	}
+	ready_queue_push(t);
 
 	t->status = THREAD_READY;
 	intr_set_level(old_level);
@@ -317,10 +594,13 @@ void thread_exit(void)
 #ifdef USERPROG
 	process_exit();
 #endif
+	malloc_thread_exit();
+	thread_cache_trim();
 
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable();
+	list_remove(&thread_current()->allelem);
 	do_schedule(THREAD_DYING);
 	NOT_REACHED();
 }
@@ -334,10 +614,9 @@ void thread_yield(void)
 
 	if (!intr_context()){
 		old_level = intr_disable();
-		if (curr != idle_thread)
-			{
-			list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
-			}
+		curr->ready_ns = timer_now_ns();
+		if (!is_idle(curr))
+			ready_queue_push(curr);
 		do_schedule(THREAD_READY);
 		intr_set_level(old_level);
 
@@ -348,6 +627,11 @@ void thread_yield(void)
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void thread_set_priority(int new_priority)
 {
+	/* The 4.4BSD scheduler computes priorities itself, except
+	   for real-time threads. */
+	if (thread_mlfqs && !is_rt(thread_current()))
+		return;
+
 	thread_current()->init_priority = new_priority;
 	refresh_priority();
 	test_max_priority();
@@ -360,48 +644,197 @@ int thread_get_priority(void)
 	return thread_current()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
-void thread_set_nice(int nice UNUSED)
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority, yielding if it no longer has the highest one. */
+void thread_set_nice(int nice)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+
+	if (nice < NICE_MIN)
+		nice = NICE_MIN;
+	if (nice > NICE_MAX)
+		nice = NICE_MAX;
+
+	old_level = intr_disable();
+	curr->nice = nice;
+	if (thread_mlfqs && !is_rt(curr))
+		synch_change_priority(curr, mlfqs_priority(curr));
+	intr_set_level(old_level);
+	test_max_priority();
+}
+
+/* Returns the current thread's scheduling policy. */
+enum sched_policy thread_get_policy(void)
 {
-	/* TODO  */
+	return thread_current()->policy;
+}
+
+/* Sets the current thread's scheduling policy to POLICY.  A
+   real-time thread keeps its priority, which then orders it
+   among the other real-time threads.  New threads always start
+   out as SCHED_OTHER. */
+void thread_set_policy(enum sched_policy policy)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+
+	ASSERT(policy == SCHED_OTHER || policy == SCHED_FIFO
+		   || policy == SCHED_RR);
+
+	old_level = intr_disable();
+	if (curr->policy != SCHED_OTHER && policy == SCHED_OTHER)
+	{
+		/* Rejoin time sharing where the others are now. */
+		if (thread_mlfqs)
+			synch_change_priority(curr, mlfqs_priority(curr));
+		if (thread_cfs && curr->vruntime < runqueue.min_vruntime)
+			curr->vruntime = runqueue.min_vruntime;
+	}
+	curr->policy = policy;
+	runqueue.slice_ticks = 0;
+	intr_set_level(old_level);
+	test_max_priority();
 }
 
 /* Returns the current thread's nice value. */
 int thread_get_nice(void)
 {
-	/* TODO */
-	return 0;
+	return thread_current()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int thread_get_load_avg(void)
 {
-	/* TODO  */
-	return 0;
+	enum intr_level old_level = intr_disable();
+	int load = fp_to_int_round(fp_mul_int(load_avg, 100));
+	intr_set_level(old_level);
+	return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int thread_get_recent_cpu(void)
 {
-	/* TODO */
-	return 0;
+	struct thread *curr = thread_current();
+	enum intr_level old_level = intr_disable();
+	int recent;
+
+	mlfqs_catch_up(curr);
+	recent = fp_to_int_round(fp_mul_int(curr->recent_cpu, 100));
+	intr_set_level(old_level);
+	return recent;
+}
+
+/* Applies to T's recent_cpu every per-second decay it has missed
+   since T->load_epoch.  Decay factors older than DECAY_HISTORY
+   seconds are no longer known; the oldest one still recorded is
+   used in their place.  Repeated decay by one factor D moves
+   recent_cpu monotonically toward nice / (1 - D), so those extra
+   seconds are replayed only until the value stops changing, which
+   bounds the work by the decay rate instead of the gap length. */
+static void
+mlfqs_catch_up(struct thread *t)
+{
+	int64_t missed = load_epoch - t->load_epoch;
+	int64_t e;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (missed > DECAY_HISTORY)
+	{
+		int oldest = decay_history[(load_epoch - DECAY_HISTORY) % DECAY_HISTORY];
+		int64_t extra = missed - DECAY_HISTORY;
+
+		while (extra-- > 0)
+		{
+			int next = fp_add_int(fp_mul(oldest, t->recent_cpu), t->nice);
+			if (next == t->recent_cpu)
+				break;
+			t->recent_cpu = next;
+		}
+		missed = DECAY_HISTORY;
+	}
+	for (e = load_epoch - missed; e < load_epoch; e++)
+		t->recent_cpu = fp_add_int(fp_mul(decay_history[e % DECAY_HISTORY],
+										  t->recent_cpu),
+								   t->nice);
+	t->load_epoch = load_epoch;
+}
+
+/* Returns the 4.4BSD priority of T,
+   PRI_MAX - (recent_cpu / 4) - (nice * 2), clamped to the valid
+   range. */
+static int
+mlfqs_priority(struct thread *t)
+{
+	int priority;
+
+	mlfqs_catch_up(t);
+	priority = PRI_MAX - fp_to_int(fp_div_int(t->recent_cpu, 4)) - t->nice * 2;
+	if (priority < PRI_MIN)
+		priority = PRI_MIN;
+	if (priority > PRI_MAX)
+		priority = PRI_MAX;
+	return priority;
+}
+
+/* Once-a-second 4.4BSD bookkeeping, run from the timer interrupt:
+   updates load_avg, records this second's recent_cpu decay factor
+   and re-queues READY threads at their new priorities. */
+static void
+mlfqs_second(void)
+{
+	int ready_threads = runqueue.cnt;
+	int twice_load;
+	struct list stale;
+	int pri;
+
+	ASSERT(intr_context());
+
+	if (!is_idle(running_thread()))
+		ready_threads++;
+	load_avg = fp_add(fp_mul(fp_div(int_to_fp(59), int_to_fp(60)), load_avg),
+					  fp_mul_int(fp_div(int_to_fp(1), int_to_fp(60)), ready_threads));
+
+	/* Record this second's decay factor and start a new epoch. */
+	twice_load = fp_mul_int(load_avg, 2);
+	decay_history[load_epoch % DECAY_HISTORY] =
+		fp_div(twice_load, fp_add_int(twice_load, 1));
+	load_epoch++;
+
+	/* Re-queue READY threads under their decayed priorities. */
+	list_init(&stale);
+	for (pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		while (!list_empty(&runqueue.queues[pri - PRI_MIN]))
+		{
+			list_push_back(&stale, list_pop_front(&runqueue.queues[pri - PRI_MIN]));
+			runqueue.cnt--;
+		}
+	runqueue.mask = 0;
+	while (!list_empty(&stale))
+	{
+		struct thread *t = list_entry(list_pop_front(&stale), struct thread, elem);
+		synch_change_priority(t, mlfqs_priority(t));
+		ready_queue_push(t);
+	}
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
-   to it to enable thread_start() to continue, and immediately
-   blocks.  After that, the idle thread never appears in the
-   ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   point it registers itself as the idle thread, "up"s the
+   semaphore passed to it to enable thread_start() to continue,
+   and immediately blocks.  After that, the idle thread never
+   appears in the ready list.  It is returned by
+   next_thread_to_run() as a special case when the ready list is
+   empty. */
 static void
 idle(void *idle_started_ UNUSED)
 {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current();
+	runqueue.idle = thread_current();
 	sema_up(idle_started);
 
 	for (;;)
@@ -410,6 +843,10 @@ idle(void *idle_started_ UNUSED)
 		intr_disable();
 		thread_block();
 
+		/* Nothing else is runnable: stop the periodic tick until
+		   the next sleeper is due, if tickless idle is enabled. */
+		timer_tickless_enter();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -445,6 +882,8 @@ kernel_thread(thread_func *function, void *aux)
 static void
 init_thread(struct thread *t, const char *name, int priority)
 {
+	enum intr_level old_level;
+
 	ASSERT(t != NULL);
 	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT(name != NULL);
@@ -452,7 +891,7 @@ init_thread(struct thread *t, const char *name, int priority)
 	memset(t, 0, sizeof *t);
 	t->status = THREAD_BLOCKED;
 	strlcpy(t->name, name, sizeof t->name);
-	t->tf.rsp = (uint64_t)t + PGSIZE - sizeof(void *);
+	t->stack = (uint8_t *)t + PGSIZE;
 	t->priority = priority;
 	t->magic = THREAD_MAGIC;
 	t->init_priority = priority;
@@ -460,20 +899,231 @@ init_thread(struct thread *t, const char *name, int priority)
 	t->wait_on_lock = NULL;
 
     list_init(&t->my_child);
+
+	old_level = intr_disable();
+	list_push_back(&all_list, &t->allelem);
+	intr_set_level(old_level);
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   the idle thread. */
 static struct thread *
 next_thread_to_run(void)
 {
-	if (list_empty(&ready_list))
-		return idle_thread;
+	struct thread *t = ready_queue_pop(&runqueue);
+
+	return t != NULL ? t : runqueue.idle;
+}
+
+/* Returns true if T is the idle thread. */
+static bool
+is_idle(struct thread *t)
+{
+	return t == runqueue.idle;
+}
+
+/* Returns true if T runs under a real-time policy. */
+static bool
+is_rt(struct thread *t)
+{
+	return t->policy != SCHED_OTHER;
+}
+
+/* Appends T to the run queue of its current priority, or under
+   thread_cfs inserts it by vruntime.
+   Real-time threads go on the real-time queue of their priority
+   either way. */
+static void
+ready_queue_push(struct thread *t)
+{
+	struct runqueue *rq = &runqueue;
+	int idx = t->priority - PRI_MIN;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (is_rt(t))
+	{
+		list_push_back(&rq->rt_queues[idx], &t->elem);
+		rq->rt_mask |= (uint64_t)1 << idx;
+	}
+	else if (thread_cfs)
+		rbtree_insert(&rq->tree, &t->cfs_node);
 	else
-		return list_entry(list_pop_front(&ready_list), struct thread, elem);
+	{
+		list_push_back(&rq->queues[idx], &t->elem);
+		rq->mask |= (uint64_t)1 << idx;
+	}
+	rq->cnt++;
+}
+
+/* Removes and returns the first thread of the highest non-empty
+   real-time priority level of RQ.  Failing that, returns the first
+   thread of the highest non-empty priority level or, under
+   thread_cfs, the one with the least vruntime.  Returns a null
+   pointer if RQ is empty. */
+static struct thread *
+ready_queue_pop(struct runqueue *rq)
+{
+	struct thread *t = NULL;
+	struct list *q;
+	int idx;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (rq->rt_mask != 0)
+	{
+		idx = ready_queue_max_priority(rq->rt_mask) - PRI_MIN;
+		q = &rq->rt_queues[idx];
+		t = list_entry(list_pop_front(q), struct thread, elem);
+		if (list_empty(q))
+			rq->rt_mask &= ~((uint64_t)1 << idx);
+		rq->cnt--;
+	}
+	else if (thread_cfs)
+	{
+		struct rb_node *min = rbtree_min(&rq->tree);
+
+		if (min != NULL)
+		{
+			t = rbtree_entry(min, struct thread, cfs_node);
+			rbtree_remove(&rq->tree, min);
+			if (t->vruntime > rq->min_vruntime)
+				rq->min_vruntime = t->vruntime;
+			rq->cnt--;
+		}
+	}
+	else if (rq->mask != 0)
+	{
+		idx = ready_queue_max_priority(rq->mask) - PRI_MIN;
+		q = &rq->queues[idx];
+		t = list_entry(list_pop_front(q), struct thread, elem);
+		if (list_empty(q))
+			rq->mask &= ~((uint64_t)1 << idx);
+		rq->cnt--;
+	}
+	return t;
+}
+
+/* Removes READY thread T from the run queue. */
+static void
+ready_queue_remove(struct thread *t)
+{
+	struct runqueue *rq = &runqueue;
+	int idx = t->priority - PRI_MIN;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(t->status == THREAD_READY);
+	if (is_rt(t))
+	{
+		list_remove(&t->elem);
+		if (list_empty(&rq->rt_queues[idx]))
+			rq->rt_mask &= ~((uint64_t)1 << idx);
+	}
+	else if (thread_cfs)
+		rbtree_remove(&rq->tree, &t->cfs_node);
+	else
+	{
+		list_remove(&t->elem);
+		if (list_empty(&rq->queues[idx]))
+			rq->mask &= ~((uint64_t)1 << idx);
+	}
+	rq->cnt--;
+}
+
+/* Returns the highest priority whose bit is set in MASK, one of
+   a run queue's `mask' or `rt_mask', or -1 if MASK is 0.  With
+   interrupts on the answer may be stale by the time it is used,
+   which is fine for preemption checks. */
+static int
+ready_queue_max_priority(uint64_t mask)
+{
+	if (mask == 0)
+		return -1;
+	return PRI_MIN + 63 - __builtin_clzll(mask);
+}
+
+/* Returns true if a thread in RQ should preempt CURR: any
+   real-time thread if CURR is not one, one of higher priority or,
+   under thread_cfs, one that CURR has pulled more than
+   CFS_GRANULARITY ahead of.  May be called with interrupts on,
+   which is fine for a preemption hint. */
+static bool
+ready_queue_preempts(struct runqueue *rq, struct thread *curr)
+{
+	uint64_t rt_mask = rq->rt_mask;
+
+	if (is_rt(curr))
+		return curr->priority < ready_queue_max_priority(rt_mask);
+	if (rt_mask != 0)
+		return true;
+	if (thread_cfs)
+	{
+		struct rb_node *min = rq->tree.min;
+
+		if (min == NULL)
+			return false;
+		return is_idle(curr)
+			|| rbtree_entry(min, struct thread, cfs_node)->vruntime
+				+ CFS_GRANULARITY < curr->vruntime;
+	}
+	return curr->priority < ready_queue_max_priority(rq->mask);
+}
+
+/* Returns T's fair-share weight. */
+static int
+cfs_weight(struct thread *t)
+{
+	int nice = t->nice - (t->priority - PRI_DEFAULT);
+
+	if (nice < -20)
+		nice = -20;
+	if (nice > 19)
+		nice = 19;
+	return cfs_weights[nice + 20];
+}
+
+/* Advances RQ's min_vruntime to the least vruntime among CURR
+   and RQ's ready threads, never moving it backward. */
+static void
+cfs_update_min(struct runqueue *rq, struct thread *curr)
+{
+	int64_t min = curr->vruntime;
+	struct rb_node *e = rq->tree.min;
+
+	if (e != NULL && rbtree_entry(e, struct thread, cfs_node)->vruntime < min)
+		min = rbtree_entry(e, struct thread, cfs_node)->vruntime;
+	if (min > rq->min_vruntime)
+		rq->min_vruntime = min;
+}
+
+/* Orders READY threads by ascending vruntime. */
+static bool
+vruntime_less(const struct rb_node *a, const struct rb_node *b,
+			  void *aux UNUSED)
+{
+	return rbtree_entry(a, struct thread, cfs_node)->vruntime
+		< rbtree_entry(b, struct thread, cfs_node)->vruntime;
+}
+
+/* Sets T's effective priority to PRIORITY.  A READY thread is
+   moved to the run queue of its new priority, and a waiting one
+   to its new place among the waiters, so priority donation takes
+   effect immediately wherever the lock holder is. */
+static void
+thread_change_priority(struct thread *t, int priority)
+{
+	enum intr_level old_level = intr_disable();
+
+	if (t->status == THREAD_READY && t->priority != priority)
+	{
+		ready_queue_remove(t);
+		synch_change_priority(t, priority);
+		ready_queue_push(t);
+	}
+	else
+		synch_change_priority(t, priority);
+	intr_set_level(old_level);
 }
 
 /* Use iretq to launch the thread */
@@ -506,12 +1156,14 @@ void do_iret(struct intr_frame *tf)
 		: "memory");
 }
 
-/* Switching the thread by activating the new thread's page
-   tables, and, if the previous thread is dying, destroying it.
+/* Switches to thread TH, saving the running thread's context so
+   that it resumes by returning from this function.
 
-   At this function's invocation, we just switched from thread
-   PREV, the new thread is already running, and interrupts are
-   still disabled.
+   Only the callee-saved registers and the stack pointer are
+   saved (see switch.S): every switch here is from one kernel
+   thread to another, so the full intr_frame and the serializing
+   iretq are unnecessary.  do_iret() is still used to enter user
+   mode.
 
    It's not safe to call printf() until the thread switch is
    complete.  In practice that means that printf()s should be
@@ -519,62 +1171,8 @@ void do_iret(struct intr_frame *tf)
 static void
 thread_launch(struct thread *th)
 {
-	uint64_t tf_cur = (uint64_t)&running_thread()->tf;
-	uint64_t tf = (uint64_t)&th->tf;
 	ASSERT(intr_get_level() == INTR_OFF);
-
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile(
-		/* Store registers that will be used. */
-		"push %%rax\n"
-		"push %%rbx\n"
-		"push %%rcx\n"
-		/* Fetch input once */
-		"movq %0, %%rax\n"
-		"movq %1, %%rcx\n"
-		"movq %%r15, 0(%%rax)\n"
-		"movq %%r14, 8(%%rax)\n"
-		"movq %%r13, 16(%%rax)\n"
-		"movq %%r12, 24(%%rax)\n"
-		"movq %%r11, 32(%%rax)\n"
-		"movq %%r10, 40(%%rax)\n"
-		"movq %%r9, 48(%%rax)\n"
-		"movq %%r8, 56(%%rax)\n"
-		"movq %%rsi, 64(%%rax)\n"
-		"movq %%rdi, 72(%%rax)\n"
-		"movq %%rbp, 80(%%rax)\n"
-		"movq %%rdx, 88(%%rax)\n"
-		"pop %%rbx\n" // Saved rcx
-		"movq %%rbx, 96(%%rax)\n"
-		"pop %%rbx\n" // Saved rbx
-		"movq %%rbx, 104(%%rax)\n"
-		"pop %%rbx\n" // Saved rax
-		"movq %%rbx, 112(%%rax)\n"
-		"addq $120, %%rax\n"
-		"movw %%es, (%%rax)\n"
-		"movw %%ds, 8(%%rax)\n"
-		"addq $32, %%rax\n"
-		"call __next\n" // read the current rip.
-		"__next:\n"
-		"pop %%rbx\n"
-		"addq $(out_iret -  __next), %%rbx\n"
-		"movq %%rbx, 0(%%rax)\n" // rip
-		"movw %%cs, 8(%%rax)\n"	 // cs
-		"pushfq\n"
-		"popq %%rbx\n"
-		"mov %%rbx, 16(%%rax)\n" // eflags
-		"mov %%rsp, 24(%%rax)\n" // rsp
-		"movw %%ss, 32(%%rax)\n"
-		"mov %%rcx, %%rdi\n"
-		"call do_iret\n"
-		"out_iret:\n"
-		:
-		: "g"(tf_cur), "g"(tf)
-		: "memory");
+	switch_threads(running_thread(), th);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -587,6 +1185,14 @@ do_schedule(int status)
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(thread_current()->status == THREAD_RUNNING);
 
+	/* Threads that died since the last call have switched off
+	   their pages by now. */
+	while (!list_empty(&destruction_req))
+	{
+		struct thread *victim =
+			list_entry(list_pop_front(&destruction_req), struct thread, elem);
+		thread_page_put(victim);
+	}
 	thread_current()->status = status;
 	schedule();
 }
@@ -602,8 +1208,15 @@ schedule(void)
 	ASSERT(is_thread(next));
 	next->status = THREAD_RUNNING;
 
+	/* Leaving the idle thread, possibly straight from the interrupt
+	   that woke it: bring the tick back before anything else runs. */
+	if (is_idle(curr))
+		timer_tickless_exit();
+
 	/* Start new time slice. */
-	thread_ticks = 0;
+	runqueue.slice_ticks = 0;
+
+	sched_account(curr, next);
 
 #ifdef USERPROG
 	/* Activate the new address space. */
@@ -619,12 +1232,149 @@ schedule(void)
 		   currently used bye the stack.
 		   The real destruction logic will be called at the beginning of the
 		   schedule(). */
+		if (curr->status == THREAD_DYING && curr != initial_thread)
+			list_push_back(&destruction_req, &curr->elem);
+
 		/* Before switching the thread, we first save the information
 		 * of current running. */
 		thread_launch(next);
 	}
 }
 
+/* Charges a context switch from CURR to NEXT: one voluntary or
+   involuntary switch to CURR and, if NEXT was waiting in a run
+   queue, the length of its wait to NEXT.  NEXT may be CURR. */
+static void
+sched_account(struct thread *curr, struct thread *next)
+{
+	bool voluntary = curr->status != THREAD_READY;
+	int64_t now = timer_now_ns();
+
+	if (voluntary)
+	{
+		curr->sched_stats.voluntary++;
+		sched_totals.voluntary++;
+	}
+	else
+	{
+		curr->sched_stats.involuntary++;
+		sched_totals.involuntary++;
+	}
+
+	if (next->ready_ns != 0)
+	{
+		int64_t wait = now - next->ready_ns;
+		uint64_t us = wait > 0 ? wait / 1000 : 0;
+		int b = us == 0 ? 0 : 64 - __builtin_clzll(us);
+
+		if (b >= SCHED_WAIT_BUCKETS)
+			b = SCHED_WAIT_BUCKETS - 1;
+		next->sched_stats.wait_ns += wait;
+		next->sched_stats.wait_hist[b]++;
+		sched_totals.wait_ns += wait;
+		sched_totals.wait_hist[b]++;
+		if (next->woken && is_rt(next))
+			rt_latency_record(wait);
+	}
+	next->ready_ns = 0;
+	next->woken = false;
+}
+
+/* Adds a real-time dispatch latency of NS nanoseconds to the
+   histogram. */
+static void
+rt_latency_record(int64_t ns)
+{
+	int b = 0;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	if (ns < 0)
+		ns = 0;
+	if (ns > 0)
+		b = 63 - __builtin_clzll((uint64_t)ns);
+	if (b >= RT_LATENCY_BUCKETS)
+		b = RT_LATENCY_BUCKETS - 1;
+	rt_latency_hist[b]++;
+	rt_latency_cnt++;
+	if (ns > rt_latency_max)
+		rt_latency_max = ns;
+}
+
+/* Returns a page for a new thread, from the cache of dead
+   threads' pages if possible, or a null pointer if memory is
+   exhausted.  The page's contents are garbage. */
+static struct thread *
+thread_page_get(void)
+{
+	struct thread *t = NULL;
+	enum intr_level old_level;
+
+	/* Without the cache, do what thread_create() used to. */
+	if (!thread_cache_enabled)
+		return palloc_get_page(PAL_ZERO);
+
+	old_level = intr_disable();
+	if (!list_empty(&thread_cache))
+	{
+		t = list_entry(list_pop_front(&thread_cache), struct thread, elem);
+		thread_cache_cnt--;
+	}
+	intr_set_level(old_level);
+	return t != NULL ? t : palloc_get_page(0);
+}
+
+/* Drops a reference to T's page.  A thread holds one reference
+   until it has died and switched away for good and, with user
+   programs, its parent holds another until it reaps T or exits.
+   The page goes into the cache when the last one goes.  Called
+   from do_schedule(), so it must not sleep. */
+void thread_page_put(struct thread *t)
+{
+	size_t max = thread_cache_enabled ? THREAD_CACHE_MAX : 0;
+	enum intr_level old_level = intr_disable();
+
+	ASSERT(t->page_refs > 0);
+	if (--t->page_refs == 0)
+	{
+		t->magic = 0;
+		list_push_front(&thread_cache, &t->elem);
+		if (thread_cache_cnt < max)
+			thread_cache_cnt++;
+		else
+			list_push_back(&thread_free_list, list_pop_back(&thread_cache));
+	}
+	intr_set_level(old_level);
+}
+
+/* Gives the pages on thread_free_list, and any cached pages
+   beyond THREAD_CACHE_MAX or all of them if the cache has been
+   disabled, back to palloc.  palloc_free_page() may sleep on the
+   pool lock, so this must not be called from the scheduler. */
+static void
+thread_cache_trim(void)
+{
+	size_t max = thread_cache_enabled ? THREAD_CACHE_MAX : 0;
+
+	ASSERT(!intr_context());
+	for (;;)
+	{
+		struct thread *t = NULL;
+		enum intr_level old_level = intr_disable();
+
+		if (thread_cache_cnt > max)
+		{
+			list_push_back(&thread_free_list, list_pop_back(&thread_cache));
+			thread_cache_cnt--;
+		}
+		if (!list_empty(&thread_free_list))
+			t = list_entry(list_pop_front(&thread_free_list), struct thread, elem);
+		intr_set_level(old_level);
+		if (t == NULL)
+			break;
+		palloc_free_page(t);
+	}
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t
 allocate_tid(void)
@@ -648,9 +1398,9 @@ void thread_sleep(int64_t ticks)
 	curr->wakeup_tick = ticks;
 	update_next_tick_to_awake(ticks);
 
-	if (curr != idle_thread)
+	if (!is_idle(curr))
 	{
-		list_push_back(&sleep_list, &curr->elem);
+		heap_push(&sleep_queue, &curr->sleep_elem);
 	}
 
 	do_schedule(THREAD_BLOCKED);
@@ -669,28 +1419,39 @@ int64_t get_next_tick_to_awake(void)
 	return next_tick_to_awake;
 }
 
+/* Wakes every sleeping thread whose wakeup_tick is at or before
+   TICKS, earliest deadline first, and recomputes
+   next_tick_to_awake from the new head of the sleep queue. */
 void thread_awake(int64_t ticks)
 {
-	next_tick_to_awake = INT64_MAX;
-	struct list_elem *e= list_begin(&sleep_list);
+	struct heap_elem *e;
 	struct thread *t;
 
-	for (e ; e != list_end(&sleep_list);)
+	next_tick_to_awake = INT64_MAX;
+	while ((e = heap_top(&sleep_queue)) != NULL)
 	{
-		t = list_entry(e, struct thread, elem);
-		if (t->wakeup_tick <= ticks)
-		{
-			e = list_remove(&t->elem);
-			thread_unblock(t);
-		}
-		else
+		t = heap_entry(e, struct thread, sleep_elem);
+		if (t->wakeup_tick > ticks)
 		{
 			update_next_tick_to_awake(t->wakeup_tick);
-			e = list_next(e);
+			break;
 		}
+		heap_pop(&sleep_queue);
+		thread_unblock(t);
 	}
 }
 
+/* Orders sleeping threads by ascending wakeup_tick. */
+static bool
+wakeup_less(const struct heap_elem *a, const struct heap_elem *b,
+			void *aux UNUSED)
+{
+	const struct thread *t_a = heap_entry(a, struct thread, sleep_elem);
+	const struct thread *t_b = heap_entry(b, struct thread, sleep_elem);
+
+	return t_a->wakeup_tick < t_b->wakeup_tick;
+}
+
 bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
 {
 	struct thread *t_a = list_entry(a, struct thread, elem);
@@ -701,16 +1462,12 @@ bool cmp_priority (const struct list_elem *a, const struct list_elem *b, void *a
 
 void test_max_priority(void)
 {
-	if (list_empty(&ready_list))
+	if (ready_queue_preempts(&runqueue, thread_current()))
 	{
-		return;
-	}
-	int run_priority = thread_current()->priority;
-	struct list_elem *e= list_begin(&ready_list);
-	struct thread *t = list_entry(e, struct thread, elem);
-	if (run_priority < t->priority)
-	{
-		thread_yield();
+		if (intr_context())
+			intr_yield_on_return();
+		else
+			thread_yield();
 	}
 }
 
@@ -729,7 +1486,7 @@ void donate_priority (void)
 		}
 
 		t = t->wait_on_lock->holder;
-		t->priority = cur_priority;
+		thread_change_priority(t, cur_priority);
 	}
 }
 
@@ -755,13 +1512,14 @@ void remove_with_lock (struct lock *lock)
 void refresh_priority (void)
 {
 	struct thread *curr = thread_current();
-	curr->priority = curr->init_priority;
+	int priority = curr->init_priority;
 	
 	if (list_empty(&curr->donations) == false)
 	{
 		list_sort(&curr->donations, cmp_priority, NULL);
 		struct thread *high;
 		high = list_entry(list_front(&curr->donations), struct thread, donation_elem);
-		curr->priority = high->priority;
+		priority = high->priority;
 	}
+	thread_change_priority(curr, priority);
 }
\ No newline at end of file
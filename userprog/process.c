@@ -361,7 +361,7 @@ load (const char *file_name, struct intr_frame *if_) {
 	process_activate (thread_current ());
 
 	/* 실행중인 파일 구조체를 thread 구조체에 추가 */
-	lock_acquire(&filesys_lock);
+	rwlock_acquire_write(&filesys_lock);
 	file = filesys_open (file_name);
 	if (file == NULL) {
         printf ("load: %s: open failed\n", file_name);
@@ -444,7 +444,7 @@ load (const char *file_name, struct intr_frame *if_) {
 	success = true;
 
 done:
-	lock_release(&filesys_lock);
+	rwlock_release_write(&filesys_lock);
 	return success;
 
 }
@@ -605,11 +605,11 @@ lazy_load_segment (struct page *page, void *aux) {
 	uint8_t *kva = page->frame->kva;
 	if (file_read_at(tmp_aux->file, kva, tmp_aux->read_bytes, tmp_aux->offset) != (int) tmp_aux->read_bytes)
 	{
-		free(tmp_aux);
+		kmem_cache_free (load_aux_cache, tmp_aux);
 		return false;
 	}
 	memset(kva + (tmp_aux->read_bytes), 0, tmp_aux->zero_bytes);
-	free(tmp_aux);
+	kmem_cache_free (load_aux_cache, tmp_aux);
 	return true;
 }
 
@@ -639,7 +639,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	while (read_bytes > 0 || zero_bytes > 0) {
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-		struct load_aux *tmp_aux = malloc(sizeof(struct load_aux));
+		struct load_aux *tmp_aux = kmem_cache_alloc (load_aux_cache);
 		tmp_aux->file = reopen_file;
 		tmp_aux->offset = ofs;
 		tmp_aux->read_bytes = page_read_bytes;
@@ -649,7 +649,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		if (!vm_alloc_page_with_initializer (VM_ANON, upage,
 					writable, lazy_load_segment, tmp_aux))
 			{
-				free(tmp_aux);
+				kmem_cache_free (load_aux_cache, tmp_aux);
 				return false;
 			}
 
@@ -739,7 +739,7 @@ struct thread *get_child_process(int pid) {
 void remove_child_process(struct thread *cp) {
     struct list_elem* remove_elem = &cp->child_elem;
     list_remove(remove_elem);
-    palloc_free_page(cp);
+    thread_page_put(cp);
 }
 
 int process_add_file(struct file *f) {
@@ -780,6 +780,13 @@ void process_exit(void) {
 				
     }
     file_close(t->running_file);
+
+    /* Let go of children that were never waited for.  Each holds its
+       own reference to its page until it dies, so a live child's page
+       outlives this and a dead child's goes back now. */
+    while (!list_empty(&t->my_child))
+        remove_child_process(list_entry(list_front(&t->my_child),
+                                        struct thread, child_elem));
     sema_up(&t->sema_exit);
     process_cleanup();
 
@@ -45,6 +45,7 @@ int wait(tid_t);
 pid_t fork (const char *);
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int sched_stats (struct sched_stats *);
 void check_user(void* addr,struct intr_frame *f );
 void check_user_write(void* addr,struct intr_frame *f );
 
@@ -72,7 +73,8 @@ syscall_init (void) {
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
     
-    lock_init(&filesys_lock);
+    rwlock_init(&filesys_lock);
+    rwlock_set_name(&filesys_lock, "filesys");
 }
 
 /* The main system call interface */
@@ -141,6 +143,10 @@ syscall_handler (struct intr_frame *f UNUSED) {
 
         case SYS_MUNMAP:
             munmap(f->R.rdi);
+            break;
+        case SYS_SCHED_STATS:
+            check_address(f->R.rdi);
+            f->R.rax = sched_stats((struct sched_stats *) f->R.rdi);
             break;
 		default:
 			thread_exit ();
@@ -170,8 +176,11 @@ halt (void) {
 void
 exit (int status) {
 	struct thread *t = thread_current();
-    if(lock_held_by_current_thread(&filesys_lock))
-		lock_release(&filesys_lock);
+    /* A fault in read() leaves the lock held for reading. */
+    if(rwlock_held_by_current_thread(&filesys_lock))
+		rwlock_release_write(&filesys_lock);
+    else if (rwlock_read_by_current_thread(&filesys_lock))
+		rwlock_release_read(&filesys_lock);
     t->exit_status = status;
 	printf("%s: exit(%d)\n", t->name, status);
 	thread_exit();
@@ -180,9 +189,9 @@ exit (int status) {
 bool create(const char *file , unsigned initial_size) {
     if (file == NULL) 
         exit(-1);
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write(&filesys_lock);
     bool result = filesys_create (file, initial_size);
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
     return result;
 }
 
@@ -194,7 +203,7 @@ bool remove(const char *file) {
 }
 
 int write(int fd, const void *buffer, unsigned size) {
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write(&filesys_lock);
     struct file *f = process_get_file(fd);
     int cur_size = -1;
     if(f) {
@@ -207,17 +216,17 @@ int write(int fd, const void *buffer, unsigned size) {
         }
     }
     else {
-        lock_release(&filesys_lock);
+        rwlock_release_write(&filesys_lock);
         return -1;
     }
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
     return cur_size;
 }
 
 int open (const char *file) {
    if (file)
     {   
-        lock_acquire(&filesys_lock);
+        rwlock_acquire_write(&filesys_lock);
         struct file * open_file = filesys_open(file);
 
         if (open_file)
@@ -227,12 +236,12 @@ int open (const char *file) {
                     file_deny_write(open_file); 
                 }
             int result = process_add_file(open_file);
-            lock_release(&filesys_lock);
+            rwlock_release_write(&filesys_lock);
             return result;
         }
         else
         {
-            lock_release(&filesys_lock);
+            rwlock_release_write(&filesys_lock);
             return -1;
         }
     }
@@ -244,18 +253,18 @@ int open (const char *file) {
 }
 
 int filesize(int fd) {
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_read(&filesys_lock);
     struct file *want_length_file = process_get_file(fd);
     int ret =-1;
     if (want_length_file)
     {
         ret = file_length(want_length_file);
-        lock_release(&filesys_lock);
+        rwlock_release_read(&filesys_lock);
         return ret; /* ASSERT (NULL), so we need to branch out */
     }
     else
     {
-        lock_release(&filesys_lock);
+        rwlock_release_read(&filesys_lock);
         return ret;
     }
 }
@@ -286,32 +295,33 @@ int read (int fd, void*buffer, unsigned size) {
 		    rd_buf[cur_size] = '\0';
     }
     else {
-        lock_acquire(&filesys_lock);
+        /* Reads only share the file system with each other. */
+        rwlock_acquire_read(&filesys_lock);
         if (f){
             cur_size = file_read(f, buffer, size);
         }
         else {
             cur_size =  -1;
         }
+        rwlock_release_read(&filesys_lock);
     }
-    lock_release(&filesys_lock);
     return cur_size;
 }
 
 void seek(int fd, unsigned position){
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write(&filesys_lock);
     struct file *target = process_get_file(fd);
     file_seek(target, position);
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
 } 
 
 
 
 unsigned tell(int fd){
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_read(&filesys_lock);
     struct file *target = process_get_file(fd);
     unsigned result = file_tell(target);
-    lock_release(&filesys_lock);
+    rwlock_release_read(&filesys_lock);
     return result;
 }
 
@@ -319,9 +329,9 @@ unsigned tell(int fd){
 
 
 void close(int fd){
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write(&filesys_lock);
     process_close_file(fd);
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
 }
 
 
@@ -357,20 +367,34 @@ void *mmap (void *addr, size_t length, int writable, int fd, off_t offset){
     if ((long long)length <= 0LL){
         return NULL;
     }
-    if (!lock_held_by_current_thread(&filesys_lock)) 
+    if (!rwlock_held_by_current_thread(&filesys_lock)) 
     /* if에 안걸리면 lock release만 되길래 주석 처리 */
-        lock_acquire(&filesys_lock);
+        rwlock_acquire_write(&filesys_lock);
     void* addr_mmap = do_mmap (addr,length, writable, file_mmap, offset);
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
     return addr_mmap;
 }
 
 void munmap (void *addr){
     if (addr == NULL || addr == 0)
         return NULL;
-    lock_acquire(&filesys_lock);
+    rwlock_acquire_write(&filesys_lock);
     do_munmap(addr);
-    lock_release(&filesys_lock);
+    rwlock_release_write(&filesys_lock);
+}
+
+/* Copies the calling thread's scheduler statistics to STATS.
+   Returns 0. */
+int sched_stats (struct sched_stats *stats) {
+    struct sched_stats copy;
+
+    /* Snapshot with interrupts off, then copy out, which may
+       fault the user page in. */
+    thread_get_sched_stats(&copy);
+    if (!is_user_vaddr((uint8_t *) stats + sizeof *stats - 1))
+        exit(-1);
+    memcpy(stats, &copy, sizeof copy);
+    return 0;
 }
 
 /* pt-bad-read 잡기 위해 테스트 - 정확히 이 함수들로 pass하진 않음. */
@@ -1,11 +1,8 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
-#include <bitmap.h>
 #include "vm/vm.h"
-#include "devices/disk.h"
+#include "vm/swap.h"
 
-static struct bitmap *swap_table;
-static struct disk *swap_disk;
 static bool anon_swap_in (struct page *page, void *kva);
 static bool anon_swap_out (struct page *page);
 static void anon_destroy (struct page *page);
@@ -21,11 +18,7 @@ static const struct page_operations anon_ops = {
 /* Initialize the data for anonymous pages */
 void
 vm_anon_init (void) {
-	swap_disk = disk_get(1, 1);
-	/* disk_size: SECTOR 단위로 반환
-	 * bitmap_create: PG 단위로 비트맵을 생성
-	 * 한 PG 당 8개의 SECTOR이기 때문에 8로 나눠줌 */
-	swap_table = bitmap_create (disk_size (swap_disk) / 8);
+	swap_init ();
 }
 
 /* Initialize the file mapping */
@@ -34,7 +27,7 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	/* Set up the handler */
 	page->operations = &anon_ops;
 	struct anon_page *anon_page = &page->anon;
-	anon_page->st_number = 0;
+	anon_page->st_number = SWAP_NONE;
 	return true;
 }
 
@@ -44,49 +37,84 @@ anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
 	size_t number = anon_page->st_number;
 
-	if (anon_page->st_number == -1) {
+	if (number == SWAP_NONE) {
 		return true;
 	}
 
-	for (int i = 0; i < SECTOR_PER_PAGE; i++) {
-		disk_read(swap_disk, (number * SECTOR_PER_PAGE) + i, kva + (DISK_SECTOR_SIZE * i));
-	}
-
-	page->frame->kva = kva;
-	page->frame->thread = thread_current();
-	anon_page->st_number = -1;
-	pml4_set_accessed(thread_current()->pml4, page->va, 1);
+	swap_read (number, kva);
+	anon_page->st_number = SWAP_NONE;
+	pml4_set_accessed(page->owner->pml4, page->va, 1);
 
-	/* swap_table에 해당 number 공간이 들어있다고 적기 */
-	bitmap_set(swap_table, number, false);
+	/* Pages forked from this one may still need the slot. */
+	swap_free (number);
 	return true;
 }
 
 /* Swap out the page by writing contents to the swap disk. */
 static bool
 anon_swap_out (struct page *page) {
-	struct anon_page *anon_page = &page->anon;
-	size_t number = bitmap_scan(swap_table, 0, 1, false);
-	
-	anon_page->st_number = number;
-	if (number == -1) {
-		return false;
+	return anon_swap_out_batch (&page, 1) == 1;
+}
+
+/* Swaps out the CNT pages in PAGES[], at most SWAP_BATCH_MAX, each
+ * along with the pages that share its frame copy-on-write.  They
+ * go to adjacent slots with one disk write if the swap disk has a
+ * run that long, or one at a time if not; the sharers of a frame
+ * each take a reference to its slot.  Returns the number of frames
+ * swapped out, which is less than CNT only if the swap disk is
+ * full; those are the frames of the first pages of PAGES[]. */
+size_t
+anon_swap_out_batch (struct page *pages[], size_t cnt) {
+	void *kvas[SWAP_BATCH_MAX];
+	size_t slot = swap_alloc (cnt);
+	size_t i;
+
+	if (slot == SWAP_NONE) {
+		if (cnt == 1)
+			return 0;
+		for (i = 0; i < cnt; i++)
+			if (anon_swap_out_batch (&pages[i], 1) == 0)
+				break;
+		return i;
 	}
-		
-	/* 디스크에 물리메모리 정보 적기 */
-	for (int i = 0; i < SECTOR_PER_PAGE; i++) {
-		disk_write(swap_disk, (number * SECTOR_PER_PAGE) + i, page->frame->kva + (DISK_SECTOR_SIZE * i));
-	}	
-	bitmap_set(swap_table, number, true);
-	del_frame_to_clock_list(page->frame);
-	page->frame = NULL;
-	free(page->frame);
-	pml4_clear_page(thread_current()->pml4, page->va);
-	return true;
+
+	/* Unmap first, so that the pages cannot change while they are
+	 * written.  A fault on one meanwhile waits for the eviction in
+	 * vm_do_claim_page(). */
+	for (i = 0; i < cnt; i++) {
+		struct list *sharers = &pages[i]->frame->pages;
+		struct list_elem *e;
+
+		for (e = list_begin (sharers); e != list_end (sharers);
+				e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, frame_elem);
+			pml4_clear_page (page->owner->pml4, page->va);
+		}
+		kvas[i] = pages[i]->frame->kva;
+	}
+	swap_write (slot, kvas, cnt);
+	for (i = 0; i < cnt; i++) {
+		struct list *sharers = &pages[i]->frame->pages;
+		struct list_elem *e;
+
+		for (e = list_begin (sharers); e != list_end (sharers);
+				e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, frame_elem);
+			/* swap_alloc() gave each slot its first reference. */
+			if (page != pages[i])
+				swap_dup (slot + i);
+			page->anon.st_number = slot + i;
+			page->frame = NULL;
+		}
+	}
+	return cnt;
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+
+	if (anon_page->st_number != SWAP_NONE)
+		swap_free (anon_page->st_number);
 }
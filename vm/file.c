@@ -7,7 +7,7 @@
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
 static void file_backed_destroy (struct page *page);
-static void munmap_action (struct hash_elem *e, void* aux);
+static void munmap_page (struct thread *t, struct page *page);
 
 
 /* DO NOT MODIFY this struct */
@@ -18,9 +18,13 @@ static const struct page_operations file_ops = {
 	.type = VM_FILE,
 };
 
+struct kmem_cache *file_aux_cache;
+
 /* The initializer of file vm */
 void
 vm_file_init (void) {
+	file_aux_cache = kmem_cache_create ("file_aux",
+			sizeof (struct file_aux), NULL);
 }
 
 /* Initialize the file backed page */
@@ -46,14 +50,17 @@ file_backed_swap_in (struct page *page, void *kva) {
 static bool
 file_backed_swap_out (struct page *page) {
 	struct file_page *file_page = &page->file;
-	struct thread *t = thread_current();
-	
+	struct thread *t = page->owner;
+
+	/* Unmap first, so that the owner cannot store into the frame
+	 * while it is written back.  A fault on the page meanwhile waits
+	 * for the eviction in vm_do_claim_page().  The dirty bit
+	 * survives in the cleared PTE. */
+	pml4_clear_page(t->pml4, page->va);
 	if (pml4_is_dirty(t->pml4, page->va) && page->frame != NULL) {
 		/* 디스크에 있는 파일에 변경사항 있으면 반영 *//
 		file_write_at(page->file.file, page->frame->kva, page->file.read_bytes, page->file.offset);
-		pml4_set_dirty(t->pml4, page->va, false);
 	}
-	pml4_clear_page(thread_current()->pml4, page->va);
 	return true;
 }
 
@@ -97,7 +104,7 @@ do_mmap (void *addr, size_t length, int writable,
 
 		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-		struct file_aux *tmp_aux = malloc(sizeof(struct file_aux));
+		struct file_aux *tmp_aux = kmem_cache_alloc (file_aux_cache);
 		tmp_aux->file = reopen_file;
 		tmp_aux->offset = offset;
 		tmp_aux->read_bytes = page_read_bytes;
@@ -106,7 +113,7 @@ do_mmap (void *addr, size_t length, int writable,
 		tmp_aux->mapping_id = map_id;
 		if (!vm_alloc_page_with_initializer (VM_FILE, addr, writable, lazy_map, tmp_aux) )
 			{
-				free(tmp_aux);
+				kmem_cache_free (file_aux_cache, tmp_aux);
 				return NULL;
 			}
 
@@ -132,43 +139,43 @@ lazy_map (struct page *page, void *aux){
 	page->file.offset = tmp_aux->offset;
 	page->file.read_bytes = read_bytes;
     page->file.zero_bytes = zero_bytes;
-	free(tmp_aux);
+	kmem_cache_free (file_aux_cache, tmp_aux);
 	return true;
 }
 
-/* Do the munmap */
+/* Do the munmap.  A mapping occupies consecutive pages starting at
+ * ADDR, so walk them by address instead of applying a callback to the
+ * whole SPT; each spt_remove_page() takes the table's lock itself. */
 void
 do_munmap (void *addr) {
 	struct thread *t = thread_current();
 	struct page* page = spt_find_page(&t->spt, addr);
-	struct file* curr_file = page->file.file;
-	t->spt.vm.aux = &page->mapping_id;
-
-	lock_acquire(&spt_lock);
-	hash_apply(&t->spt.vm, munmap_action);
-	lock_release(&spt_lock);	
-};
+	if (page == NULL)
+		return;
+	int mapping_id = page->mapping_id;
 
+	while (page != NULL && page->mapping_id == mapping_id) {
+		munmap_page (t, page);
+		addr += PGSIZE;
+		page = spt_find_page(&t->spt, addr);
+	}
+}
 
-void 
-munmap_action (struct hash_elem *e, void* aux) {
-	struct thread *t = thread_current();
-	struct page* page = hash_entry(e, struct page, hash_elem);
-	int mapping_id = *(int *)aux;
-	if (page->mapping_id == mapping_id) {
-		if (VM_TYPE(page->operations->type) == VM_FILE  && pml4_is_dirty(&t->pml4, page->va)) {
-			if (page->frame != NULL){
-				
-				file_write_at(page->file.file, page->frame->kva, page->file.read_bytes, page->file.offset);
-
-				for (int i = 2; i < t->next_fd; i++) {
-					if (i == page->mapping_id) {
-						t->fd_table[i] = file_reopen(page->file.file);
-					}
+/* Writes PAGE back if it is dirty and removes it from T's SPT. */
+static void
+munmap_page (struct thread *t, struct page *page) {
+	if (VM_TYPE(page->operations->type) == VM_FILE  && pml4_is_dirty(&t->pml4, page->va)) {
+		if (page->frame != NULL){
+			
+			file_write_at(page->file.file, page->frame->kva, page->file.read_bytes, page->file.offset);
+
+			for (int i = 2; i < t->next_fd; i++) {
+				if (i == page->mapping_id) {
+					t->fd_table[i] = file_reopen(page->file.file);
 				}
 			}
 		}
-		pml4_clear_page(thread_current()->pml4, page->va);
-		spt_remove_page(&t->spt, page);
 	}
+	pml4_clear_page(t->pml4, page->va);
+	spt_remove_page(&t->spt, page);
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+/* replace.c: Page replacement policies for the frame table. */
+
+#include "vm/replace.h"
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/mmu.h"
+#include "threads/thread.h"
+
+/* WSClock: a page not used for this many ticks has left its
+ * process's working set. */
+#define WSCLOCK_TAU (TIMER_FREQ / 10)
+
+/* Aging: ticks between shifts of the reference history. */
+#define AGING_PERIOD 4
+
+static struct frame *clock_select_victim (void);
+static void wsclock_note (struct frame *);
+static struct frame *wsclock_select_victim (void);
+static void aging_note (struct frame *);
+static struct frame *aging_select_victim (void);
+
+/* Plain second-chance clock over the frame table. */
+static const struct replace_policy clock_policy = {
+	.name = "clock",
+	.select_victim = clock_select_victim,
+};
+
+/* WSClock (Carr and Hennessy): the clock, but a page is only taken
+ * once it has left its owner's working set, clean file pages
+ * first. */
+static const struct replace_policy wsclock_policy = {
+	.name = "wsclock",
+	.note_insert = wsclock_note,
+	.note_access = wsclock_note,
+	.select_victim = wsclock_select_victim,
+};
+
+/* Aging: an 8-bit history of accessed bits per frame approximates
+ * LRU; the frame with the smallest history goes. */
+static const struct replace_policy aging_policy = {
+	.name = "aging",
+	.note_insert = aging_note,
+	.note_access = aging_note,
+	.select_victim = aging_select_victim,
+};
+
+static const struct replace_policy *policies[] = {
+	&clock_policy, &wsclock_policy, &aging_policy,
+};
+
+const struct replace_policy *replace_policy = &wsclock_policy;
+
+/* Shared by all policies: the next frame to look at. */
+static size_t hand;
+
+/* Aging: tick of the last shift. */
+static int64_t last_aged;
+
+/* Number of frames taken by select_victim(). */
+static long long evict_cnt;
+
+/* Selects the policy called NAME.  Returns false if there is no
+ * such policy. */
+bool
+replace_policy_set (const char *name) {
+	size_t i;
+
+	for (i = 0; i < sizeof policies / sizeof *policies; i++)
+		if (!strcmp (policies[i]->name, name)) {
+			replace_policy = policies[i];
+			return true;
+		}
+	return false;
+}
+
+/* Prints page replacement statistics. */
+void
+replace_print_stats (void) {
+	printf ("Replacement: %s policy, %lld evictions\n",
+			replace_policy->name, evict_cnt);
+}
+
+/* Returns the frame under the hand and moves the hand on. */
+static struct frame *
+advance (void) {
+	struct frame *frame = &frame_table[hand];
+
+	if (++hand == frame_cnt)
+		hand = 0;
+	return frame;
+}
+
+/* Returns true if FRAME can be evicted.  A free frame has nothing
+ * to evict.  A frame shared copy-on-write can only go if it is
+ * anonymous, since its sharers can then share the one swap slot;
+ * a shared file page has no single mapping to write back for. */
+static bool
+evictable (const struct frame *frame) {
+	if (frame->ref_cnt == 1)
+		return true;
+	return frame->ref_cnt > 1
+		&& VM_TYPE (frame->page->operations->type) == VM_ANON;
+}
+
+/* Returns whether any page in FRAME was accessed since the last
+ * call, clearing their accessed bits. */
+static bool
+test_and_clear_accessed (struct frame *frame) {
+	bool accessed = false;
+	struct list_elem *e;
+
+	for (e = list_begin (&frame->pages); e != list_end (&frame->pages);
+			e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, frame_elem);
+		uint64_t *pml4 = page->owner->pml4;
+
+		if (pml4_is_accessed (pml4, page->va)) {
+			pml4_set_accessed (pml4, page->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* Counts VICTIM, if any, as an eviction and returns it. */
+static struct frame *
+count (struct frame *victim) {
+	if (victim != NULL)
+		evict_cnt++;
+	return victim;
+}
+
+static struct frame *
+clock_select_victim (void) {
+	size_t budget = 2 * frame_cnt;
+
+	/* Two sweeps clear every accessed bit, so a frame is found
+	   within them unless no frame is evictable. */
+	while (budget-- > 0) {
+		struct frame *frame = advance ();
+		if (evictable (frame) && !test_and_clear_accessed (frame))
+			return count (frame);
+	}
+	return NULL;
+}
+
+static void
+wsclock_note (struct frame *frame) {
+	frame->last_use = timer_ticks ();
+}
+
+static struct frame *
+wsclock_select_victim (void) {
+	int64_t now = timer_ticks ();
+	struct frame *dirty = NULL;
+	struct frame *oldest = NULL;
+	size_t i;
+
+	/* One sweep.  A clean file page outside the working set can be
+	   dropped at once; failing that, take the first other old page
+	   and, if every page is in use, the least recently used.
+	   Anonymous pages never count as clean: swapping one in frees
+	   its slot, so evicting it always costs a write.  If
+	   every page had been accessed, the sweep cleared their bits,
+	   so a second one finds a victim. */
+	for (i = 0; i < 2 * frame_cnt; i++) {
+		struct frame *frame;
+
+		if (i == frame_cnt && (dirty != NULL || oldest != NULL))
+			break;
+		frame = advance ();
+
+		if (!evictable (frame))
+			continue;
+		if (test_and_clear_accessed (frame)) {
+			frame->last_use = now;
+			continue;
+		}
+		if (now - frame->last_use > WSCLOCK_TAU) {
+			if (VM_TYPE (frame->page->operations->type) == VM_FILE
+					&& !pml4_is_dirty (frame->thread->pml4, frame->page->va))
+				return count (frame);
+			if (dirty == NULL)
+				dirty = frame;
+		}
+		if (oldest == NULL || frame->last_use < oldest->last_use)
+			oldest = frame;
+	}
+	return count (dirty != NULL ? dirty : oldest);
+}
+
+static void
+aging_note (struct frame *frame) {
+	frame->age |= 0x80;
+}
+
+static struct frame *
+aging_select_victim (void) {
+	struct frame *victim = NULL;
+	size_t i;
+
+	/* Shift every history on the first eviction of each period
+	   rather than from the timer interrupt: the histories only
+	   matter while memory is short. */
+	if (timer_elapsed (last_aged) >= AGING_PERIOD) {
+		last_aged = timer_ticks ();
+		for (i = 0; i < frame_cnt; i++) {
+			struct frame *frame = &frame_table[i];
+			if (evictable (frame))
+				frame->age = (frame->age >> 1)
+					| (test_and_clear_accessed (frame) ? 0x80 : 0);
+		}
+	}
+
+	/* Starting at the hand spreads evictions among equal ages. */
+	for (i = 0; i < frame_cnt; i++) {
+		struct frame *frame = advance ();
+
+		if (!evictable (frame))
+			continue;
+		if (victim == NULL || frame->age < victim->age) {
+			victim = frame;
+			if (victim->age == 0)
+				break;
+		}
+	}
+	return count (victim);
+}
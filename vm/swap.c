@@ -0,0 +1,175 @@
+/* swap.c: Allocator for slots on the swap disk. */
+
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include "devices/disk.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Sectors per slot. */
+#define SLOT_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
+
+/* Slots per cluster. */
+#define CLUSTER_SLOTS SWAP_BATCH_MAX
+
+/* The swap disk is divided into clusters of CLUSTER_SLOTS slots.
+   swap_alloc() takes slots from the front of one cluster to the
+   back, next fit, so that pages written one after another end up
+   next to each other on disk; only then does it move on to the
+   next empty cluster.  Slots freed in the current cluster are not
+   reused until the cluster is empty again.  When no cluster is
+   empty the disk is fragmented, and runs are taken next fit
+   wherever they fit. */
+static struct disk *swap_disk;
+static size_t slot_cnt;
+static struct bitmap *used_map;         /* Slots with a reference. */
+static uint16_t *ref_cnt;               /* References per slot. */
+static uint8_t *cluster_free;           /* Free slots per cluster. */
+static size_t cluster_cnt;
+static size_t cur_cluster;              /* Cluster being filled. */
+static size_t cur_slot;                 /* Next slot in CUR_CLUSTER. */
+static struct lock swap_lock;
+
+static long long write_cnt;             /* swap_write() calls. */
+static long long write_slot_cnt;        /* Slots they wrote. */
+
+static bool take_cluster (void);
+static void take_slots (size_t slot, size_t cnt);
+
+/* Sets up the swap disk.  Without one there are no slots. */
+void
+swap_init (void) {
+	size_t i;
+
+	swap_disk = disk_get (1, 1);
+	slot_cnt = swap_disk != NULL ? disk_size (swap_disk) / SLOT_SECTORS : 0;
+	cluster_cnt = DIV_ROUND_UP (slot_cnt, CLUSTER_SLOTS);
+	used_map = bitmap_create (slot_cnt);
+	ref_cnt = calloc (slot_cnt, sizeof *ref_cnt);
+	cluster_free = malloc (cluster_cnt);
+	if (used_map == NULL || (slot_cnt > 0 && ref_cnt == NULL)
+			|| (cluster_cnt > 0 && cluster_free == NULL))
+		PANIC ("swap: out of memory");
+	for (i = 0; i < cluster_cnt; i++)
+		cluster_free[i] = CLUSTER_SLOTS;
+	/* A short last cluster never looks empty, so it is only used
+	   once the disk is fragmented. */
+	if (slot_cnt % CLUSTER_SLOTS != 0)
+		cluster_free[cluster_cnt - 1] = slot_cnt % CLUSTER_SLOTS;
+	/* No cluster is being filled yet; the first one taken is 0. */
+	cur_cluster = cluster_cnt > 0 ? cluster_cnt - 1 : 0;
+	cur_slot = slot_cnt;
+	lock_init (&swap_lock);
+}
+
+/* Allocates CNT adjacent slots, at most SWAP_BATCH_MAX, each with
+   one reference, and returns the first.  Returns SWAP_NONE if no
+   run of CNT free slots is left. */
+size_t
+swap_alloc (size_t cnt) {
+	size_t slot;
+
+	ASSERT (cnt > 0 && cnt <= SWAP_BATCH_MAX);
+
+	lock_acquire (&swap_lock);
+	if (cur_slot + cnt <= (cur_cluster + 1) * CLUSTER_SLOTS
+			&& cur_slot + cnt <= slot_cnt
+			&& bitmap_none (used_map, cur_slot, cnt))
+		slot = cur_slot;
+	else if (take_cluster ())
+		slot = cur_slot;
+	else {
+		slot = bitmap_scan_and_flip_next (used_map, cnt, false);
+		if (slot == BITMAP_ERROR) {
+			lock_release (&swap_lock);
+			return SWAP_NONE;
+		}
+	}
+	take_slots (slot, cnt);
+	if (slot == cur_slot)
+		cur_slot += cnt;
+	lock_release (&swap_lock);
+	return slot;
+}
+
+/* Adds a reference to SLOT, for a page that now shares it. */
+void
+swap_dup (size_t slot) {
+	lock_acquire (&swap_lock);
+	ASSERT (ref_cnt[slot] > 0 && ref_cnt[slot] < UINT16_MAX);
+	ref_cnt[slot]++;
+	lock_release (&swap_lock);
+}
+
+/* Drops a reference to SLOT, freeing it if that was the last. */
+void
+swap_free (size_t slot) {
+	lock_acquire (&swap_lock);
+	ASSERT (ref_cnt[slot] > 0);
+	if (--ref_cnt[slot] == 0) {
+		bitmap_reset (used_map, slot);
+		cluster_free[slot / CLUSTER_SLOTS]++;
+	}
+	lock_release (&swap_lock);
+}
+
+/* Reads SLOT into the page at KVA. */
+void
+swap_read (size_t slot, void *kva) {
+	disk_read_multiple (swap_disk, slot * SLOT_SECTORS, &kva, 1,
+			SLOT_SECTORS);
+}
+
+/* Writes the CNT pages at KVAS[] to the adjacent slots starting at
+   SLOT, with one disk command. */
+void
+swap_write (size_t slot, void *const kvas[], size_t cnt) {
+	ASSERT (cnt > 0 && cnt <= SWAP_BATCH_MAX);
+
+	disk_write_multiple (swap_disk, slot * SLOT_SECTORS,
+			(const void *const *) kvas, cnt, SLOT_SECTORS);
+	write_cnt++;
+	write_slot_cnt += cnt;
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void) {
+	printf ("Swap: %zu of %zu slots in use, %lld writes of %lld slots\n",
+			bitmap_count (used_map, 0, slot_cnt, true), slot_cnt,
+			write_cnt, write_slot_cnt);
+}
+
+/* Makes the next empty cluster after the current one, next fit,
+   the current cluster.  Returns false if there is none. */
+static bool
+take_cluster (void) {
+	size_t i;
+
+	for (i = 1; i <= cluster_cnt; i++) {
+		size_t c = (cur_cluster + i) % cluster_cnt;
+		if (cluster_free[c] == CLUSTER_SLOTS) {
+			cur_cluster = c;
+			cur_slot = c * CLUSTER_SLOTS;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Marks the CNT slots starting at SLOT in use, with one reference
+   each. */
+static void
+take_slots (size_t slot, size_t cnt) {
+	size_t i;
+
+	bitmap_set_multiple (used_map, slot, cnt, true);
+	for (i = slot; i < slot + cnt; i++) {
+		ref_cnt[i] = 1;
+		cluster_free[i / CLUSTER_SLOTS]--;
+	}
+}
@@ -57,7 +57,10 @@ uninit_initialize (struct page *page, void *kva) {
 static void
 uninit_destroy (struct page *page) {
 	struct uninit_page *uninit UNUSED = &page->uninit;
-	free(uninit->aux);
+	if (VM_TYPE (uninit->type) == VM_FILE)
+		kmem_cache_free (file_aux_cache, uninit->aux);
+	else
+		kmem_cache_free (load_aux_cache, uninit->aux);
 	return;
 }
 
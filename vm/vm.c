@@ -3,7 +3,12 @@
 #include "threads/malloc.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
+#include "vm/replace.h"
+#include "vm/swap.h"
 #include <list.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
 
 struct load_info{
     struct file *file;
@@ -19,6 +24,49 @@ struct page *page_lookup (const void *address);
 void page_destroy (const struct hash_elem *hash_elem, void *aux);
 
 #define STACK_LIMIT 0x47380000
+
+struct kmem_cache *page_cache;
+struct kmem_cache *load_aux_cache;
+
+/* Frame table: one struct frame for each page of the user pool,
+ * indexed by the page's offset from FRAME_BASE.  The replacement
+ * policy sweeps it in order.  FRAME_TABLE_LOCK guards the policy
+ * and frames being taken or given back. */
+struct frame *frame_table;
+size_t frame_cnt;
+static uint8_t *frame_base;
+static struct lock frame_table_lock;
+
+/* Signaled on FRAME_TABLE_LOCK when the reclaimer finishes writing
+ * out a batch.  Until then the batch's frames have no count but
+ * their pages still point to them, and a fault that finds the pool
+ * empty and nothing else to evict waits here too. */
+static struct condition evict_done;
+
+/* Background reclaim: when a fault leaves fewer than RECLAIM_LOW
+ * free frames in the user pool, the reclaimer thread wakes and
+ * evicts RECLAIM_BATCH frames at a time until RECLAIM_HIGH are
+ * free, so that faults rarely have to evict for themselves. */
+#define RECLAIM_BATCH SWAP_BATCH_MAX
+size_t reclaim_low;
+size_t reclaim_high;
+static struct semaphore reclaim_sema;
+static bool reclaim_awake;
+static size_t reclaim_pending;          /* Frames in the batch in flight. */
+
+static long long reclaim_wakeup_cnt;    /* Times the reclaimer woke. */
+static long long reclaim_cnt;           /* Frames it evicted. */
+static long long reclaim_direct_cnt;    /* Frames evicted by faults. */
+
+/* Page faults that reached vm_try_handle_fault().  Unlike the
+ * count in exception.c, this includes the ones it resolved. */
+static long long fault_cnt;
+
+static void frame_table_init (void);
+static void frame_release (struct frame *);
+static void reclaim_init (void);
+static void reclaim_thread (void *aux);
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void
@@ -30,9 +78,11 @@ vm_init (void) {
 #endif
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
-	list_init(&clock_list);
-	lock_init(&clock_list_lock);
-	clock_ptr = NULL;
+	frame_table_init ();
+	reclaim_init ();
+	page_cache = kmem_cache_create ("page", sizeof (struct page), NULL);
+	load_aux_cache = kmem_cache_create ("load_aux",
+			sizeof (struct load_aux), NULL);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -51,7 +101,14 @@ page_get_type (struct page *page) {
 /* Helpers */
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
+static bool vm_claim_frame (struct page *page, uint64_t *pml4);
 static struct frame *vm_evict_frame (void);
+static void vm_frame_attach (struct frame *frame, struct page *page);
+static void vm_frame_detach (struct page *page);
+static bool vm_share_frame (struct page *child, struct page *parent,
+		uint64_t *parent_pml4);
+static bool vm_share_slot (struct page *child, struct page *parent);
+static void vm_wait_eviction (struct page *page);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -66,7 +123,7 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 	/* Check wheter the upage is already occupied or not. */
 	if (spt_find_page (spt, upage) == NULL) {
 
-		struct page *new_page = malloc(sizeof(struct page));
+		struct page *new_page = kmem_cache_alloc (page_cache);
 		switch (VM_TYPE(type))
 		{
 		case VM_ANON:
@@ -90,12 +147,13 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		}
 
 		new_page->writable = writable;
+		new_page->owner = thread_current ();
 		if (spt_insert_page(spt, new_page)) {
 			return true;
 		}
 		else {
 			/* setup stack 함수가 false가 날 수 있는 상황 */
-			free (new_page);
+			kmem_cache_free (page_cache, new_page);
 			goto err;
 		}
 
@@ -110,7 +168,9 @@ spt_find_page (struct supplemental_page_table *spt, void *va) {
 	struct page page;
 	struct hash_elem *e;
 	page.va = pg_round_down(va);
+	rwlock_acquire_read(&spt->lock);
 	e = hash_find(&spt->vm, &page.hash_elem);
+	rwlock_release_read(&spt->lock);
 	return e != NULL ? hash_entry(e, struct page, hash_elem) : NULL;
 
 }
@@ -119,51 +179,31 @@ spt_find_page (struct supplemental_page_table *spt, void *va) {
 bool
 spt_insert_page (struct supplemental_page_table *spt,
 		struct page *page) {
-	int succ = false;
-	if (hash_find(&spt->vm, &page->hash_elem) == NULL) {
-		hash_insert(&spt->vm, &page->hash_elem);
-		succ = true;
-	}
-	return succ;
+	struct hash_elem *old;
+	rwlock_acquire_write(&spt->lock);
+	old = hash_insert(&spt->vm, &page->hash_elem);
+	rwlock_release_write(&spt->lock);
+	return old == NULL;
 }
 
+/* Remove PAGE from spt and free it.  Only the table update is done
+ * under the lock; tearing the page down may wait for disk I/O. */
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
-	if (hash_delete(&spt->vm, &page->hash_elem)) {
-		
+	struct hash_elem *e;
+	rwlock_acquire_write(&spt->lock);
+	e = hash_delete(&spt->vm, &page->hash_elem);
+	rwlock_release_write(&spt->lock);
+	if (e != NULL) {
 		pml4_clear_page(thread_current()->pml4, page->va);
 		vm_dealloc_page (page);
-		return true;
 	}
-	return false;
 }
 
 /* Get the struct frame, that will be evicted. */
 static struct frame *
 vm_get_victim (void) {
-	struct frame *victim = NULL;
-	struct frame *curr_frame;
-	void *va;
-
-	if (clock_ptr == NULL) {
-		clock_ptr = list_begin(&clock_list);
-	}
-
-	while (true) {
-		curr_frame = list_entry(clock_ptr, struct frame, list_elem);
-		va = curr_frame->page->va;
-		if (!pml4_is_accessed(thread_current()->pml4, va)) {
-			victim = curr_frame;
-			break;
-		}
-		pml4_set_accessed(thread_current()->pml4, va, false);
-		clock_ptr = get_next_clock();
-		if (clock_ptr == NULL) {
-			clock_ptr = list_begin(&clock_list);
-		}
-	}
-	
-	return victim;
+	return replace_policy->select_victim ();
 }
 
 /* Evict one page and return the corresponding frame.
@@ -171,29 +211,59 @@ vm_get_victim (void) {
 static struct frame *
 vm_evict_frame (void) {
 	struct frame *victim = vm_get_victim ();
-	swap_out(victim->page);
+	if (victim == NULL || !swap_out(victim->page))
+		return NULL;
+	victim->page->frame = NULL;
+	/* Before the lock is dropped: a frame with a count but no
+	 * mapping would look idle to the reclaimer. */
+	victim->page = NULL;
+	victim->thread = NULL;
+	list_init (&victim->pages);
+	victim->ref_cnt = 0;
 	return victim;
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
  * and return it. This always return valid address. That is, if the user pool
  * memory is full, this function evicts the frame to get the available memory
- * space.*/
+ * space.
+ * The frame is not counted as in use until a page is attached to it,
+ * so the replacement policy leaves it alone until then. */
 static struct frame *
 vm_get_frame (void) {
-	struct frame *frame = malloc(sizeof(struct frame));
-	if (frame == NULL)
-		free(frame);
-	ASSERT (frame != NULL);
-	frame->kva = palloc_get_page(PAL_USER);
-	if (frame->kva == NULL) {
-		free(frame);
-		lock_acquire(&clock_list_lock);
-		frame = vm_evict_frame();
-		lock_release(&clock_list_lock);
+	void *kva = palloc_get_page(PAL_USER);
+	struct frame *frame;
+
+	if (!reclaim_awake && palloc_free_cnt (PAL_USER) < reclaim_low) {
+		reclaim_awake = true;
+		sema_up (&reclaim_sema);
 	}
+
+	if (kva == NULL) {
+		/* Every frame may be in a batch the reclaimer is writing out,
+		 * where the policy cannot see it.  Wait for the batch to land
+		 * in the pool rather than give up. */
+		lock_acquire(&frame_table_lock);
+		while ((frame = vm_evict_frame()) == NULL) {
+			if (reclaim_pending == 0)
+				PANIC ("no frame to evict");
+			cond_wait (&evict_done, &frame_table_lock);
+			kva = palloc_get_page(PAL_USER);
+			if (kva != NULL)
+				break;
+		}
+		if (frame != NULL)
+			reclaim_direct_cnt++;
+		lock_release(&frame_table_lock);
+		if (frame != NULL)
+			return frame;
+	}
+
+	frame = frame_lookup (kva);
 	frame->page = NULL;
-	ASSERT (frame->page == NULL);
+	frame->thread = NULL;
+	list_init (&frame->pages);
+	frame->ref_cnt = 0;
 	return frame;
 }
 
@@ -210,9 +280,50 @@ vm_stack_growth (void *addr) {
 	}
 }
 
-/* Handle the fault on write_protected page */
+/* Handle the fault on write_protected page.  PAGE is writable but
+ * mapped read-only because it shares its frame with other pages
+ * since a fork: give it a private copy of the frame, or, if every
+ * other sharer has already left, make the frame its own again. */
 static bool
-vm_handle_wp (struct page *page UNUSED) {
+vm_handle_wp (struct page *page) {
+	struct thread *t = thread_current ();
+	struct frame *frame;
+	bool success = true;
+
+	if (!page->writable)
+		return false;
+
+	/* The reclaimer may evict the frame, shared or not, whenever the
+	 * lock is free.  The access then faults again as not present, so
+	 * returning is all it takes to retry. */
+	lock_acquire (&frame_table_lock);
+	vm_wait_eviction (page);
+	if (page->frame != NULL && page->frame->ref_cnt == 1) {
+		if (replace_policy->note_access != NULL)
+			replace_policy->note_access (page->frame);
+		pml4_set_writable (t->pml4, page->va, true);
+	}
+	if (page->frame == NULL || page->frame->ref_cnt == 1) {
+		lock_release (&frame_table_lock);
+		return true;
+	}
+	lock_release (&frame_table_lock);
+
+	frame = vm_get_frame ();
+	lock_acquire (&frame_table_lock);
+	vm_wait_eviction (page);
+	if (page->frame == NULL || page->frame->ref_cnt == 1) {
+		/* The other sharers left, or the frame was evicted, while
+		 * the new one was found. */
+		frame_release (frame);
+	} else {
+		memcpy (frame->kva, page->frame->kva, PGSIZE);
+		vm_frame_detach (page);
+		success = pml4_set_page (t->pml4, page->va, frame->kva, true);
+		vm_frame_attach (frame, page);
+	}
+	lock_release (&frame_table_lock);
+	return success;
 }
 
 /* Return true on success */
@@ -221,8 +332,12 @@ vm_try_handle_fault (struct intr_frame *f, void *addr,
 		bool user, bool write, bool not_present) {
 	struct supplemental_page_table *spt = &thread_current ()->spt;
 	struct page *page = NULL;
+	fault_cnt++;
     if (write && !not_present) {
-        exit(-1);
+        page = spt_find_page (spt, addr);
+        if (page == NULL || !vm_handle_wp (page))
+            exit(-1);
+        return true;
     }
     if (addr == NULL || addr == 0) {
         exit(-1);
@@ -258,8 +373,17 @@ vm_try_handle_fault (struct intr_frame *f, void *addr,
 /* Free the page. */
 void
 vm_dealloc_page (struct page *page) {
+	lock_acquire (&frame_table_lock);
+	vm_wait_eviction (page);
+	if (page->frame != NULL) {
+		/* Unmap it first, so that pml4_destroy() does not free a
+		 * frame that other pages still share. */
+		pml4_clear_page (thread_current ()->pml4, page->va);
+		vm_frame_detach (page);
+	}
+	lock_release (&frame_table_lock);
 	destroy (page);
-	free (page);
+	kmem_cache_free (page_cache, page);
 }
 
 /* Claim the page that allocate on VA. */
@@ -280,42 +404,166 @@ vm_do_claim_page (struct page *page) {
 	if (page == NULL)
 		return false;
 
+	/* A page being swapped out is unmapped before it is written:
+	 * wait for the eviction to finish, then bring it back. */
+	if (page->frame != NULL) {
+		bool resident;
+
+		lock_acquire (&frame_table_lock);
+		vm_wait_eviction (page);
+		resident = page->frame != NULL;
+		lock_release (&frame_table_lock);
+		if (resident)
+			return true;
+	}
+
+	return vm_claim_frame (page, thread_current ()->pml4);
+}
+
+/* Gives PAGE a frame, swaps its contents in and maps it in PML4.
+ * The frame only becomes evictable once all of that is done. */
+static bool
+vm_claim_frame (struct page *page, uint64_t *pml4) {
 	struct frame *frame = vm_get_frame ();
-	frame->page = page;
+
+	/* Loaders reach the frame through the page. */
 	page->frame = frame;
-	struct thread *t = thread_current();
-	if (!pml4_set_page(t->pml4, page->va, frame->kva, page->writable)) {
+	if (!swap_in (page, frame->kva)
+			|| !pml4_set_page(pml4, page->va, frame->kva, page->writable)) {
+		page->frame = NULL;
+		free_frame (frame->kva);
 		return false;
 	}
-	
-	add_frame_to_clock_list(frame);
 
-	return swap_in (page, frame->kva);
+	vm_frame_attach (frame, page);
+	return true;
+}
+
+/* Adds PAGE to the pages using FRAME. */
+static void
+vm_frame_attach (struct frame *frame, struct page *page) {
+	list_push_back (&frame->pages, &page->frame_elem);
+	if (frame->page == NULL) {
+		frame->page = page;
+		frame->thread = page->owner;
+		if (replace_policy->note_insert != NULL)
+			replace_policy->note_insert (frame);
+	}
+	page->frame = frame;
+	/* Last, since the replacement policy takes a frame with a count
+	 * for in use and reads its page. */
+	frame->ref_cnt++;
+}
+
+/* Removes PAGE from the pages using its frame, and frees the
+ * frame if PAGE was the last.  PAGE must already be unmapped, and
+ * the frame table locked. */
+static void
+vm_frame_detach (struct page *page) {
+	struct frame *frame = page->frame;
+
+	list_remove (&page->frame_elem);
+	page->frame = NULL;
+	if (--frame->ref_cnt > 0) {
+		if (frame->page == page) {
+			frame->page = list_entry (list_front (&frame->pages),
+					struct page, frame_elem);
+			frame->thread = frame->page->owner;
+		}
+		return;
+	}
+
+	frame_release (frame);
+}
+
+/* Makes CHILD, a new uninit page in the running thread, share
+ * the frame of its resident twin PARENT, whose process uses
+ * PARENT_PML4.  Both are mapped read-only so that the first write
+ * to either goes through vm_handle_wp().  The frame table must be
+ * locked, so that PARENT is not evicted meanwhile. */
+static bool
+vm_share_frame (struct page *child, struct page *parent,
+		uint64_t *parent_pml4) {
+	struct uninit_page *uninit = &child->uninit;
+	struct frame *frame = parent->frame;
+
+	/* Turn CHILD into its final type without loading anything,
+	 * then take over PARENT's per-type data. */
+	if (!uninit->page_initializer (child, uninit->type, frame->kva))
+		return false;
+	if (VM_TYPE (parent->operations->type) == VM_FILE)
+		child->file = parent->file;
+	else
+		child->anon = parent->anon;
+	child->mapping_id = parent->mapping_id;
+
+	if (!pml4_set_page (thread_current ()->pml4, child->va, frame->kva,
+				false))
+		return false;
+	vm_frame_attach (frame, child);
+	pml4_set_writable (parent_pml4, parent->va, false);
+	return true;
+}
+
+/* Makes CHILD, a new uninit page in the running thread, share
+ * the swap slot of its swapped-out anonymous twin PARENT.  The
+ * frame table must be locked, so that PARENT is not swapped in
+ * meanwhile. */
+static bool
+vm_share_slot (struct page *child, struct page *parent) {
+	struct uninit_page *uninit = &child->uninit;
+
+	if (!uninit->page_initializer (child, uninit->type, NULL))
+		return false;
+	child->anon = parent->anon;
+	child->mapping_id = parent->mapping_id;
+	swap_dup (child->anon.st_number);
+	return true;
+}
+
+/* Waits until PAGE is not in a batch that the reclaimer is writing
+ * out.  The frame table must be locked.  A direct eviction holds
+ * the lock throughout, so it needs no waiting for. */
+static void
+vm_wait_eviction (struct page *page) {
+	while (page->frame != NULL && page->frame->ref_cnt == 0)
+		cond_wait (&evict_done, &frame_table_lock);
 }
 
 /* Initialize new supplemental page table */
 void
 supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
 	hash_init(&spt->vm, page_hash, page_less, NULL);
-	lock_init(&spt_lock);
+	rwlock_init(&spt->lock);
+	rwlock_set_name(&spt->lock, "spt");
 }
 
 /* Copy supplemental page table from src to dst */
 bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
+	/* SRC is embedded in the parent's struct thread, which starts
+	 * its page. */
+	struct thread *parent = pg_round_down (src);
 	bool result = false;
 	struct load_aux *aux_child;
 	struct hash_iterator i;
-	lock_acquire(&spt_lock);
+	rwlock_acquire_read(&src->lock);
 	hash_first(&i, &src->vm);
 	while (hash_next(&i)){
 		struct page *child_page;
 		struct page* parent_page = hash_entry(hash_cur(&i), struct page, hash_elem);
 		switch(parent_page->operations->type){
 			case VM_UNINIT: /* UNINIT인 페이지는 할당해야 함. */
-				aux_child = malloc(sizeof(struct load_aux));
-				memcpy(aux_child, parent_page->uninit.aux,sizeof(struct load_aux));
+				if (VM_TYPE (parent_page->uninit.type) == VM_FILE) {
+					aux_child = kmem_cache_alloc (file_aux_cache);
+					memcpy (aux_child, parent_page->uninit.aux,
+							sizeof (struct file_aux));
+				} else {
+					aux_child = kmem_cache_alloc (load_aux_cache);
+					memcpy (aux_child, parent_page->uninit.aux,
+							sizeof (struct load_aux));
+				}
 				result = vm_alloc_page_with_initializer(
 					parent_page->uninit.type, \ 
 					parent_page->va, \
@@ -325,41 +573,43 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 				break;
 
 			case VM_ANON:
-				result = vm_alloc_page(parent_page->operations->type,parent_page->va, parent_page->writable);
-				child_page->mapping_id = parent_page->mapping_id;
-				child_page->anon.st_number = parent_page->anon.st_number;
-
-				if (result){
-					child_page = spt_find_page(&thread_current()->spt, parent_page->va );
-					if (vm_do_claim_page(child_page) == 0){
-						return false ;
-						}
-					memcpy(child_page->frame->kva, parent_page->frame->kva, PGSIZE); 
-					}
-				break;
-
 			case VM_FILE:
+				/* Share the parent's frame copy-on-write, or its
+				 * swap slot if it is anonymous and swapped out.  A
+				 * file page that was evicted is brought back in
+				 * first. */
 				result = vm_alloc_page(parent_page->operations->type,parent_page->va, parent_page->writable);
-				child_page->mapping_id = parent_page->mapping_id;
-				child_page->file.file = parent_page->file.file;
-				child_page->file.offset = parent_page->file.offset;
-				child_page->file.read_bytes = parent_page->file.read_bytes;
-				child_page->file.zero_bytes = parent_page->file.zero_bytes;
-				child_page->file.writable = parent_page->file.writable;
-				if (result){
-					struct page *child_page = spt_find_page(&thread_current()->spt, parent_page->va );
-					if (vm_do_claim_page(child_page) == 0){
-						return false ;
-						}
-					memcpy(child_page->frame->kva, parent_page->frame->kva, PGSIZE); 
+				if (!result)
+					break;
+				child_page = spt_find_page(&thread_current()->spt, parent_page->va);
+				lock_acquire (&frame_table_lock);
+				vm_wait_eviction (parent_page);
+				while (parent_page->frame == NULL
+						&& VM_TYPE (parent_page->operations->type) != VM_ANON) {
+					lock_release (&frame_table_lock);
+					if (!vm_claim_frame (parent_page, parent->pml4)) {
+						rwlock_release_read(&src->lock);
+						return false;
 					}
+					lock_acquire (&frame_table_lock);
+					vm_wait_eviction (parent_page);
+				}
+				if (parent_page->frame != NULL)
+					result = vm_share_frame (child_page, parent_page, parent->pml4);
+				else
+					result = vm_share_slot (child_page, parent_page);
+				lock_release (&frame_table_lock);
+				if (!result) {
+					rwlock_release_read(&src->lock);
+					return false;
+				}
 				break;
 
 			default:
 				break;
 		}
 	}
-	lock_release(&spt_lock);
+	rwlock_release_read(&src->lock);
 
 	return result;
 
@@ -398,52 +648,156 @@ page_delete(const struct hash_elem *e, void *aux){
 	vm_dealloc_page(page_for_deletion);
 }
 
-void
-add_frame_to_clock_list(struct frame *frame) {
-	list_push_back(&clock_list, &frame->list_elem);
+/* Sets up the frame table to cover the whole user pool. */
+static void
+frame_table_init (void) {
+	size_t i;
+
+	frame_cnt = palloc_pool_range (PAL_USER, (void **) &frame_base);
+	frame_table = palloc_get_multiple (PAL_ASSERT | PAL_ZERO,
+			DIV_ROUND_UP (frame_cnt * sizeof *frame_table, PGSIZE));
+	for (i = 0; i < frame_cnt; i++) {
+		frame_table[i].kva = frame_base + i * PGSIZE;
+		list_init (&frame_table[i].pages);
+	}
+	lock_init (&frame_table_lock);
+	lock_set_name (&frame_table_lock, "frame_table");
+	cond_init (&evict_done);
 }
 
-void
-del_frame_to_clock_list(struct frame *frame) {
-	if (!list_empty(&clock_list))
-		list_remove(&frame->list_elem);
+/* Returns the frame for KVA, a page of the user pool. */
+struct frame *
+frame_lookup (void *kva) {
+	size_t idx = pg_no (kva) - pg_no (frame_base);
+
+	ASSERT (idx < frame_cnt);
+	return &frame_table[idx];
 }
 
 struct frame*
 alloc_frame(void) {
-	struct frame *frame = vm_get_frame();
-	add_frame_to_clock_list(frame);
-	return frame;
+	return vm_get_frame();
 }
- 
+
+/* Gives the frame for KVA back to the user pool. */
 void 
 free_frame(void *kva) {
-	struct list_elem *e;
-	struct frame *frame;
-	for (e = list_begin(&clock_list); e != list_end(&clock_list);) {
-		frame = list_entry(e, struct frame, list_elem);
-		if (frame->kva == kva) {
-			__free_page(frame);
-			break;
-		}
-		e = list_next(e);
-	}
-	return;
+	lock_acquire (&frame_table_lock);
+	frame_release (frame_lookup (kva));
+	lock_release (&frame_table_lock);
 }
 
-void 
-__free_page(struct frame *frame) {
-	del_frame_to_clock_list(frame);
-	free(frame);
+/* Gives FRAME back to the user pool.  The frame table must be
+ * locked. */
+static void
+frame_release (struct frame *frame) {
+	palloc_free_page (frame->kva);
+	frame->page = NULL;
+	frame->thread = NULL;
+	frame->ref_cnt = 0;
 }
 
-struct list_elem*
-get_next_clock() {
-	clock_ptr = list_next(clock_ptr);
-	if (clock_ptr == list_end(&clock_list))
-		return NULL;
-	return clock_ptr;
+/* Sets the watermarks from the size of the user pool and starts
+ * the reclaimer. */
+static void
+reclaim_init (void) {
+	reclaim_low = frame_cnt / 64;
+	if (reclaim_low < RECLAIM_BATCH)
+		reclaim_low = RECLAIM_BATCH;
+	reclaim_high = 2 * reclaim_low;
+	sema_init (&reclaim_sema, 0);
+	reclaim_awake = false;
+	thread_create ("reclaim", PRI_DEFAULT + 1, reclaim_thread, NULL);
 }
 
+/* Evicts up to RECLAIM_BATCH frames into the user pool.  Returns
+ * false if it ran out of frames to evict or swap slots.
+ * The victims are chosen with the frame table locked and taken out
+ * of the replacement policy's sight by zeroing their counts.  The
+ * lock is then dropped while anonymous victims are written to
+ * adjacent swap slots with one disk command and file-backed ones
+ * go back to their files, so that faults that find a free frame or
+ * evict for themselves do not wait for the disk.  Faults on the
+ * victims' pages wait in vm_wait_eviction(). */
+static bool
+reclaim_batch (void) {
+	struct frame *anon_victims[RECLAIM_BATCH];
+	struct page *anon_pages[RECLAIM_BATCH];
+	struct frame *file_victims[RECLAIM_BATCH];
+	bool file_done[RECLAIM_BATCH];
+	struct frame *frame = NULL;
+	size_t anon_cnt = 0, file_cnt = 0, done, i;
+	bool success = true;
+
+	lock_acquire (&frame_table_lock);
+	for (i = 0; i < RECLAIM_BATCH; i++) {
+		frame = vm_get_victim ();
+		if (frame == NULL)
+			break;
+		/* A frame without a count is never selected, so this one is
+		 * not chosen again for the same batch. */
+		frame->ref_cnt = 0;
+		if (VM_TYPE (frame->page->operations->type) == VM_ANON) {
+			anon_victims[anon_cnt] = frame;
+			anon_pages[anon_cnt++] = frame->page;
+		} else
+			file_victims[file_cnt++] = frame;
+	}
+	reclaim_pending = anon_cnt + file_cnt;
+	lock_release (&frame_table_lock);
+
+	done = anon_cnt > 0 ? anon_swap_out_batch (anon_pages, anon_cnt) : 0;
+	for (i = 0; i < file_cnt; i++)
+		file_done[i] = swap_out (file_victims[i]->page);
+
+	lock_acquire (&frame_table_lock);
+	for (i = 0; i < anon_cnt; i++) {
+		if (i < done) {
+			frame_release (anon_victims[i]);
+			reclaim_cnt++;
+		} else {
+			anon_victims[i]->ref_cnt = list_size (&anon_victims[i]->pages);
+			success = false;
+		}
+	}
+	for (i = 0; i < file_cnt; i++) {
+		if (file_done[i]) {
+			file_victims[i]->page->frame = NULL;
+			frame_release (file_victims[i]);
+			reclaim_cnt++;
+		} else {
+			file_victims[i]->ref_cnt = 1;
+			success = false;
+		}
+	}
+	reclaim_pending = 0;
+	cond_broadcast (&evict_done, &frame_table_lock);
+	lock_release (&frame_table_lock);
+	return frame != NULL && success;
+}
 
+/* Reclaimer thread: sleeps until vm_get_frame() sees the free
+ * frames fall below RECLAIM_LOW, then evicts until RECLAIM_HIGH
+ * are free. */
+static void
+reclaim_thread (void *aux UNUSED) {
+	for (;;) {
+		sema_down (&reclaim_sema);
+		reclaim_wakeup_cnt++;
+		while (palloc_free_cnt (PAL_USER) < reclaim_high && reclaim_batch ())
+			continue;
+		reclaim_awake = false;
+	}
+}
 
+/* Prints virtual memory statistics. */
+void
+vm_print_stats (void) {
+	printf ("VM: %lld page faults\n", fault_cnt);
+	replace_print_stats ();
+	swap_print_stats ();
+	printf ("Reclaim: watermarks %zu/%zu, %lld wakeups, "
+			"%lld frames in background, %lld direct\n",
+			reclaim_low, reclaim_high, reclaim_wakeup_cnt, reclaim_cnt,
+			reclaim_direct_cnt);
+}